@@ -0,0 +1,1022 @@
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <list>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <ranges>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "budget_allocator.hpp"
+#include "channel.hpp"
+#include "huge_page_allocator.hpp"
+#include "list.hpp"
+#include "lru_cache.hpp"
+#include "memory_utils.hpp"
+#include "numa_allocator.hpp"
+#include "rcu_list.hpp"
+#include "shm_allocator.hpp"
+#include "slot_map.hpp"
+#include "small_list.hpp"
+#include "utils.hpp"
+
+template <size_t Size>
+struct Payload {
+  int key = 0;
+  char rest[Size - sizeof(int)];
+};
+
+// same sizes as Payload<N>, but kept out of line to compare both layouts
+struct ColdPayload256 : Payload<256> {};
+struct ColdPayload1024 : Payload<1024> {};
+
+template <>
+struct ListNodeLayout<ColdPayload256> {
+  static constexpr bool value_out_of_line = true;
+};
+
+template <>
+struct ListNodeLayout<ColdPayload1024> {
+  static constexpr bool value_out_of_line = true;
+};
+
+size_t MemoryManager::type_new_allocated = 0;
+size_t MemoryManager::type_new_deleted = 0;
+size_t MemoryManager::allocator_allocated = 0;
+size_t MemoryManager::allocator_deallocated = 0;
+size_t MemoryManager::allocator_constructed = 0;
+size_t MemoryManager::allocator_destroyed = 0;
+size_t MemoryManager::allocator_calls = 0;
+
+size_t Accountant::ctor_calls = 0;
+size_t Accountant::dtor_calls = 0;
+bool ThrowingAccountant::need_throw = false;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template <typename F>
+double MeasureSeconds(F&& func) {
+  auto start = Clock::now();
+  func();
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// keeps results of measured loops observable
+volatile long long benchmark_sink = 0;
+
+void Report(const std::string& name, size_t ops, double seconds) {
+  std::printf("%-48s %14.0f ops/s %10.3f ms\n", name.c_str(),
+              static_cast<double>(ops) / seconds, seconds * 1e3);
+}
+
+// Producer and consumer are separate processes that map the same file
+// independently, so the list is reached through different base addresses.
+void BenchShmProducerConsumer() {
+  using ShmList = List<int, ShmAllocator<int>>;
+  struct Channel {
+    ShmSpinLock lock;
+    ShmList list;
+    std::atomic<bool> done{false};
+
+    explicit Channel(ShmArena* arena) : list(ShmAllocator<int>(arena)) {}
+  };
+
+  constexpr size_t kSegmentSize = 64 << 20;
+  constexpr int kItems = 1000000;
+  constexpr int kBatch = 64;
+  const std::string path =
+      "/tmp/list_bench_shm_" + std::to_string(::getpid());
+
+  ShmSegment producer_segment(path, kSegmentSize, true);
+  ShmArena* arena = producer_segment.arena();
+  Channel* channel = arena->construct<Channel>(arena);
+  arena->set_root(channel);
+
+  double seconds = MeasureSeconds([&] {
+    pid_t consumer = ::fork();
+    if (consumer == 0) {
+      ShmSegment consumer_segment(path, kSegmentSize, false);
+      Channel* shared = consumer_segment.arena()->root<Channel>();
+      long long sum = 0;
+      int received = 0;
+      while (received < kItems) {
+        std::lock_guard<ShmSpinLock> guard(shared->lock);
+        while (!shared->list.empty()) {
+          sum += *shared->list.begin();
+          shared->list.pop_front();
+          ++received;
+        }
+      }
+      long long expected = static_cast<long long>(kItems) * (kItems - 1) / 2;
+      ::_exit(sum == expected ? 0 : 1);
+    }
+    for (int sent = 0; sent < kItems; sent += kBatch) {
+      std::lock_guard<ShmSpinLock> guard(channel->lock);
+      for (int i = sent; i < sent + kBatch && i < kItems; ++i) {
+        channel->list.push_back(i);
+      }
+    }
+    int status = 0;
+    ::waitpid(consumer, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::fprintf(stderr, "shm consumer saw corrupted data\n");
+    }
+  });
+  Report("shm producer/consumer (2 processes)", kItems, seconds);
+  channel->~Channel();
+  ::unlink(path.c_str());
+}
+
+void BenchBulkPushPop() {
+  constexpr size_t kItems = 1 << 20;
+  constexpr size_t kBatch = 256;
+  std::vector<int> batch(kBatch, 1);
+  std::vector<int> out;
+  out.reserve(kBatch);
+
+  List<int> single;
+  double seconds = MeasureSeconds([&] {
+    for (size_t sent = 0; sent < kItems; sent += kBatch) {
+      for (int value : batch) {
+        single.push_back(value);
+      }
+      out.clear();
+      for (size_t i = 0; i < kBatch; ++i) {
+        out.push_back(*single.begin());
+        single.pop_front();
+      }
+    }
+  });
+  Report("push_back + pop_front, one at a time", kItems, seconds);
+
+  List<int> bulk;
+  seconds = MeasureSeconds([&] {
+    for (size_t sent = 0; sent < kItems; sent += kBatch) {
+      bulk.push_back_bulk(batch);
+      out.clear();
+      bulk.pop_front_n(kBatch, std::back_inserter(out));
+    }
+  });
+  Report("push_back_bulk + pop_front_n", kItems, seconds);
+}
+
+template <typename ListType>
+void BenchShortLivedLists(const std::string& name) {
+  constexpr size_t kLists = 1 << 18;
+  constexpr int kElements = 6;
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < kLists; ++i) {
+      ListType lst;
+      for (int j = 0; j < kElements; ++j) {
+        lst.push_back(j);
+      }
+      for (int value : lst) {
+        sum += value;
+      }
+    }
+  });
+  benchmark_sink = sum;
+  Report(name, kLists, seconds);
+}
+
+void BenchSmallList() {
+  BenchShortLivedLists<List<int>>("List<int>, 6 elements");
+  BenchShortLivedLists<SmallList<int, 8>>("SmallList<int, 8>, 6 elements");
+}
+
+template <typename Value>
+void BenchTraversal(const std::string& name) {
+  constexpr size_t kNodes = 1 << 20;
+  constexpr int kPasses = 4;
+  List<Value> lst;
+  for (size_t i = 0; i < kNodes; ++i) {
+    lst.emplace_back();
+  }
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (auto& value : lst) {
+        sum += value.key;
+      }
+    }
+  });
+  const std::string node =
+      ", node " + std::to_string(List<Value>::node_size) + " B";
+  Report(name + node + ", read key", kNodes * kPasses, seconds);
+
+  seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      sum += std::distance(lst.begin(), lst.end());
+    }
+  });
+  benchmark_sink = sum;
+  Report(name + node + ", links only", kNodes * kPasses, seconds);
+}
+
+void BenchNodeLayout() {
+  BenchTraversal<Payload<4>>("T = 4 B");
+  BenchTraversal<Payload<40>>("T = 40 B");
+  BenchTraversal<Payload<256>>("T = 256 B inline");
+  BenchTraversal<ColdPayload256>("T = 256 B cold");
+  BenchTraversal<Payload<1024>>("T = 1024 B inline");
+  BenchTraversal<ColdPayload1024>("T = 1024 B cold");
+}
+
+// Readers scan a routing-table sized list while one writer replaces an entry
+// every kWritePeriod; reports total scans per second over all readers.
+template <typename Table>
+void RunReadMostly(const std::string& name, Table& table, int readers) {
+  constexpr auto kDuration = std::chrono::milliseconds(300);
+  constexpr auto kWritePeriod = std::chrono::microseconds(50);
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> scans{0};
+  // readers publish their sums here, and only the main thread writes the sink
+  std::atomic<long long> total{0};
+  std::vector<std::thread> threads;
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&] {
+      size_t local = 0;
+      long long sum = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        sum += table.scan();
+        ++local;
+      }
+      total += sum;
+      scans += local;
+    });
+  }
+  auto start = Clock::now();
+  int next = 0;
+  while (Clock::now() - start < kDuration) {
+    table.replace(next++ % 1024);
+    std::this_thread::sleep_for(kWritePeriod);
+  }
+  stop = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  benchmark_sink = total.load();
+  double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  Report(name + ", " + std::to_string(readers) + " readers", scans.load(),
+         seconds);
+}
+
+struct LockedTable {
+  List<int> list;
+  std::shared_mutex mutex;
+
+  long long scan() {
+    std::shared_lock<std::shared_mutex> guard(mutex);
+    long long sum = 0;
+    for (int value : list) {
+      sum += value;
+    }
+    return sum;
+  }
+
+  void replace(int value) {
+    std::unique_lock<std::shared_mutex> guard(mutex);
+    list.pop_front();
+    list.push_back(value);
+  }
+};
+
+struct RcuTable {
+  RcuList<int> list;
+
+  long long scan() {
+    auto guard = list.read();
+    long long sum = 0;
+    for (int value : guard) {
+      sum += value;
+    }
+    return sum;
+  }
+
+  void replace(int value) {
+    list.pop_front();
+    list.push_back(value);
+  }
+};
+
+void BenchRcuReaders() {
+  int cores = static_cast<int>(std::thread::hardware_concurrency());
+  for (int readers = 1; readers <= std::max(1, cores - 1); readers *= 2) {
+    LockedTable locked;
+    RcuTable rcu;
+    for (int i = 0; i < 1024; ++i) {
+      locked.list.push_back(i);
+      rcu.list.push_back(i);
+    }
+    RunReadMostly("shared_mutex + List scan", locked, readers);
+    RunReadMostly("RcuList scan", rcu, readers);
+  }
+}
+
+// the usual hand-rolled cache: std::list plus an index of list iterators;
+// an eviction frees the old node and allocates a new one
+class StdListLru {
+ private:
+  size_t capacity_;
+  std::list<std::pair<int, int>> entries_;
+  std::unordered_map<int, std::list<std::pair<int, int>>::iterator> index_;
+
+ public:
+  explicit StdListLru(size_t capacity) : capacity_(capacity) {}
+
+  int* get(int key) {
+    auto found = index_.find(key);
+    if (found == index_.end()) {
+      return nullptr;
+    }
+    entries_.splice(entries_.end(), entries_, found->second);
+    return &found->second->second;
+  }
+
+  void put(int key, int value) {
+    if (entries_.size() == capacity_) {
+      index_.erase(entries_.front().first);
+      entries_.pop_front();
+    }
+    entries_.emplace_back(key, value);
+    index_[key] = --entries_.end();
+  }
+};
+
+template <typename Cache>
+void RunCache(const std::string& name, Cache& cache, size_t key_space) {
+  constexpr size_t kOps = 1 << 21;
+  std::vector<int> keys(kOps);
+  uint64_t state = 42;
+  for (auto& key : keys) {
+    // skewed toward small keys, roughly like a hot working set
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint64_t r = state >> 33;
+    key = static_cast<int>((r * r >> 31) % key_space);
+  }
+  size_t hits = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int key : keys) {
+      if (int* value = cache.get(key)) {
+        ++*value;
+        ++hits;
+      } else {
+        cache.put(key, key);
+      }
+    }
+  });
+  Report(name + ", hit rate " + std::to_string(hits * 100 / kOps) + "%", kOps,
+         seconds);
+}
+
+void BenchLruCache() {
+  constexpr size_t kCapacity = 4096;
+  for (size_t key_space : {8192u, 65536u}) {
+    StdListLru hand_rolled(kCapacity);
+    RunCache("std::list + unordered_map LRU", hand_rolled, key_space);
+    LruCache<int, int> cache(kCapacity);
+    RunCache("LruCache", cache, key_space);
+  }
+}
+
+template <typename Tracer>
+void RunTracedPushPop(const std::string& name) {
+  constexpr size_t kItems = 1 << 22;
+  List<int, std::allocator<int>, Tracer> lst;
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < kItems; ++i) {
+      lst.push_back(static_cast<int>(i));
+      sum += *lst.begin();
+      lst.pop_front();
+    }
+  });
+  benchmark_sink = sum;
+  Report(name, kItems, seconds);
+}
+
+void BenchTracing() {
+  RunTracedPushPop<NullListTracer>("push_back + pop_front, NullListTracer");
+  RunTracedPushPop<RingBufferListTracer>(
+      "push_back + pop_front, RingBufferListTracer");
+}
+
+template <typename Alloc>
+void RunFill(const std::string& name, bool reserve) {
+  constexpr size_t kItems = 1 << 16;
+  constexpr int kRounds = 64;
+  MemoryManager::allocator_calls = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      List<int, Alloc> lst;
+      if (reserve) {
+        lst.reserve(kItems);
+      }
+      for (size_t i = 0; i < kItems; ++i) {
+        lst.push_back(static_cast<int>(i));
+      }
+    }
+  });
+  Report(name + ", " +
+             std::to_string(MemoryManager::allocator_calls / kRounds) +
+             " allocations",
+         kItems * kRounds, seconds);
+}
+
+void BenchAllocateAtLeast() {
+  RunFill<AllocatorWithCount<int>>("AllocatorWithCount", false);
+  RunFill<AllocatorWithCount<int>>("AllocatorWithCount, reserve", true);
+  RunFill<SizeClassAllocatorWithCount<int>>("SizeClassAllocator", false);
+  RunFill<SizeClassAllocatorWithCount<int>>("SizeClassAllocator, reserve",
+                                            true);
+}
+
+template <typename MakeCopy>
+void RunCopy(const std::string& name, MakeCopy&& make_copy) {
+  constexpr int kRounds = 16;
+  size_t copied = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      auto copy = make_copy();
+      copied += copy.size();
+    }
+  });
+  Report(name, copied, seconds);
+}
+
+template <typename T>
+void RunCopies(const std::string& type) {
+  constexpr size_t kItems = 1000000;
+  std::list<T> std_source(kItems);
+  List<T> source(kItems);
+  RunCopy("std::list<" + type + "> copy",
+          [&] { return std::list<T>(std_source); });
+  RunCopy("List<" + type + "> copy", [&] { return List<T>(source); });
+  RunCopy("List<" + type + "> into AllocatorWithCount",
+          [&] { return List<T, AllocatorWithCount<T>>(source); });
+  // what the copy constructor did before the chain-building path
+  RunCopy("List<" + type + "> push_back loop", [&] {
+    List<T> copy;
+    for (auto iter = source.cbegin(); iter != source.cend(); ++iter) {
+      copy.push_back(*iter);
+    }
+    return copy;
+  });
+}
+
+void BenchCopy() {
+  RunCopies<int>("int");
+  RunCopies<Accountant>("Accountant");
+}
+
+// the condition variable queue the channel replaces
+template <typename T>
+class CondvarQueue {
+ public:
+  explicit CondvarQueue(size_t capacity) : capacity_(capacity) {}
+
+  void push(T value) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [&] { return items_.size() < capacity_; });
+    items_.push_back(std::move(value));
+    not_empty_.notify_one();
+  }
+
+  T pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [&] { return !items_.empty(); });
+    T value = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return value;
+  }
+
+ private:
+  size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::list<T> items_;
+};
+
+DetachedTask ProduceInto(Channel<int>& channel, int count) {
+  for (int i = 0; i < count; ++i) {
+    co_await channel.push(i);
+  }
+  channel.close();
+}
+
+DetachedTask ConsumeFrom(Channel<int>& channel, size_t batch,
+                         std::atomic<bool>& done) {
+  long long sum = 0;
+  if (batch == 1) {
+    while (std::optional<int> value = co_await channel.pop()) {
+      sum += *value;
+    }
+  } else {
+    for (;;) {
+      List<int> values = co_await channel.pop_n(batch);
+      if (values.empty()) {
+        break;
+      }
+      for (int value : values) {
+        sum += value;
+      }
+    }
+  }
+  benchmark_sink = sum;
+  done.store(true, std::memory_order_release);
+}
+
+DetachedTask Echo(Channel<int>& in, Channel<int>& out) {
+  while (std::optional<int> value = co_await in.pop()) {
+    co_await out.push(*value);
+  }
+}
+
+DetachedTask Ping(Channel<int>& out, Channel<int>& in, int rounds) {
+  for (int i = 0; i < rounds; ++i) {
+    co_await out.push(i);
+    co_await in.pop();
+  }
+  out.close();
+}
+
+void BenchChannel() {
+  constexpr int kItems = 1000000;
+  constexpr size_t kCapacity = 1024;
+
+  CondvarQueue<int> queue(kCapacity);
+  double seconds = MeasureSeconds([&] {
+    std::thread producer([&] {
+      for (int i = 0; i < kItems; ++i) {
+        queue.push(i);
+      }
+      queue.push(-1);
+    });
+    long long sum = 0;
+    for (int value; (value = queue.pop()) >= 0;) {
+      sum += value;
+    }
+    producer.join();
+    benchmark_sink = sum;
+  });
+  Report("mutex + condvar queue, 2 threads", kItems, seconds);
+
+  // a waiter is resumed inline by whoever satisfies it, so a consumer that
+  // waits on an empty channel is handed one value per wakeup; batches form
+  // when the producer runs ahead, as it does when started first here
+  for (bool producer_first : {false, true}) {
+    for (size_t batch : {size_t{1}, size_t{256}}) {
+      Channel<int> channel(kCapacity);
+      std::atomic<bool> done{false};
+      seconds = MeasureSeconds([&] {
+        if (!producer_first) {
+          ConsumeFrom(channel, batch, done);
+        }
+        std::thread producer([&] { ProduceInto(channel, kItems); });
+        producer.join();
+        if (producer_first) {
+          ConsumeFrom(channel, batch, done);
+        }
+        while (!done.load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+      });
+      Report(std::string("Channel, ") +
+                 (producer_first ? "producer ahead, " : "consumer waiting, ") +
+                 (batch == 1 ? "pop()" : "pop_n(256)"),
+             kItems, seconds);
+    }
+  }
+
+  // one item bounced between two stages and back
+  constexpr int kRounds = 100000;
+  CondvarQueue<int> to_echo(1);
+  CondvarQueue<int> from_echo(1);
+  seconds = MeasureSeconds([&] {
+    std::thread echo([&] {
+      for (int value; (value = to_echo.pop()) >= 0;) {
+        from_echo.push(value);
+      }
+    });
+    for (int i = 0; i < kRounds; ++i) {
+      to_echo.push(i);
+      from_echo.pop();
+    }
+    to_echo.push(-1);
+    echo.join();
+  });
+  Report("mutex + condvar round trip", kRounds, seconds);
+
+  Channel<int> to_stage(1);
+  Channel<int> from_stage(1);
+  seconds = MeasureSeconds([&] {
+    Echo(to_stage, from_stage);
+    Ping(to_stage, from_stage, kRounds);
+  });
+  Report("Channel round trip", kRounds, seconds);
+}
+
+// both containers go through the same churn: fill, erase a random half,
+// refill; handles are then looked up in random order and the whole
+// container is scanned
+void BenchSlotMap() {
+  constexpr size_t kItems = 1 << 18;
+  constexpr int kPasses = 16;
+  std::vector<size_t> order(kItems);
+  uint64_t state = 7;
+  for (size_t i = 0; i < kItems; ++i) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    order[i] = (state >> 33) % kItems;
+  }
+
+  List<int> lst;
+  std::vector<List<int>::iterator> iterators;
+  SlotMap<int> map;
+  std::vector<SlotMapHandle> handles;
+  for (size_t i = 0; i < kItems; ++i) {
+    lst.push_back(static_cast<int>(i));
+    iterators.push_back(--lst.end());
+    handles.push_back(map.push_back(static_cast<int>(i)));
+  }
+  for (size_t i = 0; i < kItems; i += 2) {
+    size_t victim = order[i];
+    if (map.erase(handles[victim])) {
+      lst.erase(iterators[victim]);
+      lst.push_back(static_cast<int>(victim));
+      iterators[victim] = --lst.end();
+      handles[victim] = map.push_back(static_cast<int>(victim));
+    }
+  }
+
+  std::printf("bytes per element: List node %zu, SlotMap slot %zu\n",
+              List<int>::node_size, SlotMap<int>::slot_size);
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (size_t index : order) {
+        sum += *iterators[index];
+      }
+    }
+  });
+  Report("List, iterator lookup", kItems * kPasses, seconds);
+  seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (size_t index : order) {
+        sum += *map.get(handles[index]);
+      }
+    }
+  });
+  Report("SlotMap, handle lookup", kItems * kPasses, seconds);
+  seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (int value : lst) {
+        sum += value;
+      }
+    }
+  });
+  Report("List, full scan", kItems * kPasses, seconds);
+  seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (int value : map) {
+        sum += value;
+      }
+    }
+  });
+  Report("SlotMap, full scan", kItems * kPasses, seconds);
+  benchmark_sink = sum;
+}
+
+// push_back + pop_front allocates and frees a node per item, so every item
+// charges and releases the budget once; a reserved list charges nothing.
+template <typename Alloc>
+void RunBudgetPushPop(const std::string& name, Alloc alloc, bool reserve) {
+  constexpr size_t kItems = 1 << 22;
+  List<int, Alloc> lst(alloc);
+  if (reserve) {
+    lst.reserve(2);
+  }
+  // keeps the sentinel alive, so only the element nodes come and go
+  lst.push_back(0);
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (size_t i = 0; i < kItems; ++i) {
+      lst.push_back(static_cast<int>(i));
+      sum += *lst.begin();
+      lst.pop_front();
+    }
+  });
+  benchmark_sink = sum;
+  Report(name, kItems, seconds);
+}
+
+void BenchBudget() {
+  MemoryBudget budget(1 << 20);
+  RunBudgetPushPop("push_back + pop_front, std::allocator",
+                   std::allocator<int>(), false);
+  RunBudgetPushPop("push_back + pop_front, BudgetAllocator",
+                   BudgetAllocator<int>(budget), false);
+  RunBudgetPushPop("push_back + pop_front, std::allocator, reserve",
+                   std::allocator<int>(), true);
+  RunBudgetPushPop("push_back + pop_front, BudgetAllocator, reserve",
+                   BudgetAllocator<int>(budget), true);
+}
+
+using NumaList = List<int, NumaAllocator<int>>;
+
+// runs func on a thread pinned to the CPUs of a NUMA node
+template <typename F>
+void RunOnNode(int node, F&& func) {
+  std::thread worker([&] {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (int cpu : Numa::cpus_of(node)) {
+      CPU_SET(cpu, &cpus);
+    }
+    if (CPU_COUNT(&cpus) > 0) {
+      pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+    func();
+  });
+  worker.join();
+}
+
+// the links are shuffled, so every ++ is a dependent miss to the node's
+// memory instead of a prefetched stride
+void RunNumaTraversal(const std::string& name, NumaList& lst, int reader) {
+  constexpr int kPasses = 4;
+  long long sum = 0;
+  double seconds = 0;
+  RunOnNode(reader, [&] {
+    seconds = MeasureSeconds([&] {
+      for (int pass = 0; pass < kPasses; ++pass) {
+        for (int value : lst) {
+          sum += value;
+        }
+      }
+    });
+  });
+  benchmark_sink = sum;
+  Report(name, lst.size() * kPasses, seconds);
+}
+
+void BenchNuma() {
+  constexpr size_t kItems = 1 << 21;
+  int remote = Numa::node_count() - 1;
+  NumaList lst{NumaAllocator<int>(0)};
+  std::vector<NumaList::iterator> order;
+  RunOnNode(0, [&] {
+    for (size_t i = 0; i < kItems; ++i) {
+      lst.push_back(static_cast<int>(i));
+      order.push_back(--lst.end());
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    for (NumaList::iterator iter : order) {
+      lst.splice(lst.end(), lst, iter);
+    }
+  });
+  RunNumaTraversal("node 0 reads node 0", lst, 0);
+  if (remote == 0) {
+    std::printf("single NUMA node, no remote traversal to measure\n");
+    return;
+  }
+  const std::string reader = "node " + std::to_string(remote);
+  RunNumaTraversal(reader + " reads node 0", lst, remote);
+  size_t moved = 0;
+  RunOnNode(remote, [&] { moved = lst.migrate_to_node(remote); });
+  RunNumaTraversal(reader + " reads node " + std::to_string(remote) +
+                       " after migrate_to_node (" + std::to_string(moved) +
+                       " pages)",
+                   lst, remote);
+}
+
+// Filtering and transforming into a temporary List against a lazy views
+// pipeline, consumed directly or collected with to_list.
+void BenchViews() {
+  constexpr size_t kItems = 1 << 16;
+  constexpr int kRounds = 64;
+  List<int> source;
+  for (size_t i = 0; i < kItems; ++i) {
+    source.push_back(static_cast<int>(i));
+  }
+  auto is_even = [](int value) { return value % 2 == 0; };
+  auto square = [](int value) { return value * value; };
+  auto pipeline = source | std::views::filter(is_even) |
+                  std::views::transform(square);
+
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      List<int> temporary;
+      for (int value : source) {
+        if (is_even(value)) {
+          temporary.push_back(square(value));
+        }
+      }
+      for (int value : temporary) {
+        sum += value;
+      }
+    }
+  });
+  Report("temporary List, then sum", kItems * kRounds, seconds);
+
+  seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      for (int value : pipeline) {
+        sum += value;
+      }
+    }
+  });
+  Report("views pipeline, summed lazily", kItems * kRounds, seconds);
+
+  seconds = MeasureSeconds([&] {
+    for (int round = 0; round < kRounds; ++round) {
+      auto collected =
+          pipeline | to_list<List<int, SizeClassAllocatorWithCount<int>>>();
+      sum += static_cast<long long>(collected.size());
+    }
+  });
+  Report("views pipeline | to_list, run allocator", kItems * kRounds,
+         seconds);
+  benchmark_sink = sum;
+}
+
+// dTLB load misses of the calling thread, in user space; -1 where
+// perf_event_open is not permitted (perf_event_paranoid, containers)
+class TlbMissCounter {
+ public:
+  TlbMissCounter() {
+    perf_event_attr attr{};
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  TlbMissCounter(const TlbMissCounter&) = delete;
+  TlbMissCounter& operator=(const TlbMissCounter&) = delete;
+
+  ~TlbMissCounter() {
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+  }
+
+  void start() {
+    if (fd_ >= 0) {
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  long long stop() {
+    long long count = -1;
+    if (fd_ < 0 || ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0) != 0 ||
+        read(fd_, &count, sizeof(count)) != sizeof(count)) {
+      return -1;
+    }
+    return count;
+  }
+
+ private:
+  int fd_;
+};
+
+// a shuffled list spans far more 4K pages than the TLB covers, so each ++
+// risks a page walk; 2 MB slabs cut the pages touched by 512
+template <typename Alloc>
+void RunHugePageTraversal(const std::string& name, Alloc alloc) {
+  constexpr size_t kItems = 1 << 22;
+  constexpr int kPasses = 2;
+  List<int, Alloc> lst(alloc);
+  {
+    std::vector<typename List<int, Alloc>::iterator> order;
+    order.reserve(kItems);
+    for (size_t i = 0; i < kItems; ++i) {
+      lst.push_back(static_cast<int>(i));
+      order.push_back(--lst.end());
+    }
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    for (auto iter : order) {
+      lst.splice(lst.end(), lst, iter);
+    }
+  }
+  TlbMissCounter misses;
+  long long sum = 0;
+  misses.start();
+  double seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (int value : lst) {
+        sum += value;
+      }
+    }
+  });
+  long long count = misses.stop();
+  benchmark_sink = sum;
+  char per_node[32] = "n/a";
+  if (count >= 0) {
+    std::snprintf(per_node, sizeof(per_node), "%.2f",
+                  static_cast<double>(count) / (kItems * kPasses));
+  }
+  Report(name + ", dTLB misses/node " + per_node, kItems * kPasses, seconds);
+}
+
+void BenchHugePages() {
+  RunHugePageTraversal("std::allocator", std::allocator<int>());
+  HugePageAllocator<int> huge;
+  RunHugePageTraversal("HugePageAllocator", huge);
+  std::printf("HugePageAllocator slabs: %s\n",
+              HugePageBackingName(huge.arena()->backing()));
+}
+
+// Build with -DLIST_CHECKED_ITERATORS to see what the checks cost; without
+// it the iterator is a bare node pointer and matches std::list.
+void BenchIterators() {
+  constexpr size_t kItems = 1 << 18;
+  constexpr int kPasses = 16;
+  List<int> lst;
+  std::list<int> reference;
+  for (size_t i = 0; i < kItems; ++i) {
+    lst.push_back(static_cast<int>(i));
+    reference.push_back(static_cast<int>(i));
+  }
+  const std::string size =
+      ", iterator " + std::to_string(sizeof(List<int>::iterator)) + " B";
+  long long sum = 0;
+  double seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (int value : lst) {
+        sum += value;
+      }
+    }
+  });
+  Report("List, full scan" + size, kItems * kPasses, seconds);
+
+  seconds = MeasureSeconds([&] {
+    for (int pass = 0; pass < kPasses; ++pass) {
+      for (int value : reference) {
+        sum += value;
+      }
+    }
+  });
+  Report("std::list, full scan", kItems * kPasses, seconds);
+  benchmark_sink = sum;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const std::vector<std::pair<std::string, void (*)()>> benchmarks = {
+      {"shm", BenchShmProducerConsumer},
+      {"bulk", BenchBulkPushPop},
+      {"small", BenchSmallList},
+      {"layout", BenchNodeLayout},
+      {"rcu", BenchRcuReaders},
+      {"lru", BenchLruCache},
+      {"trace", BenchTracing},
+      {"runs", BenchAllocateAtLeast},
+      {"copy", BenchCopy},
+      {"channel", BenchChannel},
+      {"slotmap", BenchSlotMap},
+      {"budget", BenchBudget},
+      {"numa", BenchNuma},
+      {"views", BenchViews},
+      {"hugepages", BenchHugePages},
+      {"iterators", BenchIterators},
+  };
+  for (const auto& [name, bench] : benchmarks) {
+    bool selected = argc == 1;
+    for (int i = 1; i < argc; ++i) {
+      selected = selected || name == argv[i];
+    }
+    if (selected) {
+      bench();
+    }
+  }
+}
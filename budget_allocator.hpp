@@ -0,0 +1,172 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Thrown when an allocation would take a MemoryBudget past its limit. It is
+// a std::bad_alloc, so code that already survives allocation failure keeps
+// working.
+class MemoryBudgetExceeded : public std::bad_alloc {
+ public:
+  MemoryBudgetExceeded(size_t requested, size_t used, size_t limit)
+      : requested_(requested), used_(used), limit_(limit) {}
+
+  const char* what() const noexcept override {
+    return "memory budget exceeded";
+  }
+
+  // getters
+  size_t requested() const { return requested_; }
+
+  size_t used() const { return used_; }
+
+  size_t limit() const { return limit_; }
+
+ private:
+  size_t requested_;
+  size_t used_;
+  size_t limit_;
+};
+
+// Byte limit shared by every allocator charged against it, e.g. all the
+// containers of one tenant. Charging is a single compare-and-swap, so the
+// limit is exact across threads. The budget must outlive its allocators.
+class MemoryBudget {
+ public:
+  explicit MemoryBudget(size_t limit) : limit_(limit) {}
+
+  MemoryBudget(const MemoryBudget&) = delete;
+  MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+  // throws MemoryBudgetExceeded and charges nothing if bytes do not fit
+  void charge(size_t bytes) {
+    size_t used = used_.load(std::memory_order_relaxed);
+    do {
+      size_t limit = limit_.load(std::memory_order_relaxed);
+      if (bytes > limit || used > limit - bytes) {
+        throw MemoryBudgetExceeded(bytes, used, limit);
+      }
+    } while (!used_.compare_exchange_weak(used, used + bytes,
+                                          std::memory_order_relaxed));
+  }
+
+  void release(size_t bytes) noexcept {
+    used_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  // lowering the limit below used() only makes further charges fail
+  void set_limit(size_t limit) {
+    limit_.store(limit, std::memory_order_relaxed);
+  }
+
+  // getters
+  size_t used() const { return used_.load(std::memory_order_relaxed); }
+
+  size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<size_t> used_{0};
+  std::atomic<size_t> limit_;
+};
+
+// Allocator that charges every allocation of Upstream to a MemoryBudget
+// before making it, so a container over its limit fails with
+// MemoryBudgetExceeded without touching Upstream. Construction is left to
+// allocator_traits, which keeps List's memcpy copy path available.
+template <class T, class Upstream = std::allocator<T>>
+class BudgetAllocator {
+ private:
+  template <class U, class OtherUpstream>
+  friend class BudgetAllocator;
+
+  using upstream_type =
+      typename std::allocator_traits<Upstream>::template rebind_alloc<T>;
+  using upstream_traits = std::allocator_traits<upstream_type>;
+
+  MemoryBudget* budget_;
+  upstream_type upstream_;
+
+ public:
+  using value_type = T;
+  using pointer = typename upstream_traits::pointer;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+  // List takes runs of nodes exactly when Upstream asks for them
+  using node_runs = std::bool_constant<
+      requires { requires upstream_type::node_runs::value; }>;
+
+  template <class U>
+  struct rebind {
+    using other = BudgetAllocator<
+        U, typename std::allocator_traits<Upstream>::template rebind_alloc<U>>;
+  };
+
+  // constructors
+  explicit BudgetAllocator(MemoryBudget& budget,
+                           const Upstream& upstream = Upstream())
+      : budget_(&budget), upstream_(upstream) {}
+
+  template <class U, class OtherUpstream>
+  BudgetAllocator(const BudgetAllocator<U, OtherUpstream>& other)
+      : budget_(other.budget_), upstream_(other.upstream_) {}
+
+  // methods
+  pointer allocate(size_t n) {
+    budget_->charge(n * sizeof(T));
+    try {
+      return upstream_traits::allocate(upstream_, n);
+    } catch (...) {
+      budget_->release(n * sizeof(T));
+      throw;
+    }
+  }
+
+  void deallocate(pointer ptr, size_t n) {
+    upstream_traits::deallocate(upstream_, ptr, n);
+    budget_->release(n * sizeof(T));
+  }
+
+  // offered only when Upstream hands out runs; the surplus it returns is
+  // charged as well, and the whole run is given back if that does not fit
+  auto allocate_at_least(size_t n)
+    requires requires(upstream_type& alloc) { alloc.allocate_at_least(n); }
+  {
+    budget_->charge(n * sizeof(T));
+    decltype(upstream_.allocate_at_least(n)) result;
+    try {
+      result = upstream_.allocate_at_least(n);
+    } catch (...) {
+      budget_->release(n * sizeof(T));
+      throw;
+    }
+    if (result.count > n) {
+      try {
+        budget_->charge((result.count - n) * sizeof(T));
+      } catch (...) {
+        upstream_traits::deallocate(upstream_, result.ptr, result.count);
+        budget_->release(n * sizeof(T));
+        throw;
+      }
+    }
+    return result;
+  }
+
+  // getters
+  MemoryBudget& budget() const { return *budget_; }
+
+  template <class U, class OtherUpstream>
+  bool operator==(const BudgetAllocator<U, OtherUpstream>& other) const {
+    return budget_ == other.budget_ &&
+           upstream_ == upstream_type(other.upstream_);
+  }
+
+  template <class U, class OtherUpstream>
+  bool operator!=(const BudgetAllocator<U, OtherUpstream>& other) const {
+    return !(*this == other);
+  }
+};
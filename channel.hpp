@@ -0,0 +1,314 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+
+#include "list.hpp"
+
+// Fire-and-forget coroutine for driving the channel's awaitables: it runs
+// until its first suspension right away and frees its frame when it
+// finishes. An exception escaping it terminates.
+struct DetachedTask {
+  struct promise_type {
+    DetachedTask get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+// Bounded multi-producer multi-consumer channel for coroutines. A value is
+// moved into a node of the channel's queue, or straight to a consumer that
+// is already waiting, so T is never copied. The queue is long-lived and
+// keeps its sentinel and a spare node while empty: a steady one-in one-out
+// stream does not call the allocator. pop_n receives its values as nodes
+// spliced out of the queue. A producer that finds the channel full stages
+// its value in a node of its own, which is spliced in once space frees. A
+// suspended waiter is resumed on the thread that satisfied it, after the
+// channel lock is released.
+template <class T, class Allocator = std::allocator<T>>
+class Channel {
+ public:
+  // usings
+  using value_type = T;
+  using allocator_type = Allocator;
+  using list_type = List<T, Allocator>;
+
+ private:
+  // a suspended push or pop; nodes holds the staged value of a producer or
+  // receives the values handed to pop_n, value receives the one of pop
+  class Waiter {
+   public:
+    Waiter* next = nullptr;
+    std::coroutine_handle<> handle;
+    list_type nodes;
+    std::optional<T> value;
+    size_t want = 0;
+    bool batch = false;
+    bool accepted = false;
+
+    Waiter(const Allocator& alloc, size_t want, bool batch)
+        : nodes(alloc), want(want), batch(batch) {}
+
+    bool received() const { return value.has_value() || !nodes.empty(); }
+  };
+
+  class WaiterQueue {
+   public:
+    Waiter* head = nullptr;
+    Waiter* tail = nullptr;
+
+    void push(Waiter* waiter) {
+      waiter->next = nullptr;
+      if (tail == nullptr) {
+        head = waiter;
+      } else {
+        tail->next = waiter;
+      }
+      tail = waiter;
+    }
+
+    Waiter* pop() {
+      Waiter* waiter = head;
+      head = waiter->next;
+      if (head == nullptr) {
+        tail = nullptr;
+      }
+      waiter->next = nullptr;
+      return waiter;
+    }
+
+    bool empty() const { return head == nullptr; }
+  };
+
+  Allocator alloc_;
+  size_t capacity_;
+  std::mutex mutex_;
+  list_type items_;
+  WaiterQueue producers_;
+  WaiterQueue consumers_;
+  bool closed_ = false;
+
+  // waiters to resume once the lock is dropped, linked through next
+  static void resume_all(Waiter* waiter) {
+    while (waiter != nullptr) {
+      Waiter* next = waiter->next;
+      waiter->handle.resume();
+      waiter = next;
+    }
+  }
+
+  static void prepend(Waiter*& wake, Waiter* waiter) {
+    waiter->next = wake;
+    wake = waiter;
+  }
+
+  // lock held; hands the value straight to a waiting consumer or queues
+  // it, false when the channel is full. The consumer leaves its queue only
+  // once it holds the value, so a throwing move changes nothing
+  bool deliver(T& value, Waiter*& wake) {
+    if (!consumers_.empty()) {
+      Waiter* consumer = consumers_.head;
+      if (consumer->batch) {
+        consumer->nodes.push_back(std::move(value));
+      } else {
+        consumer->value.emplace(std::move(value));
+      }
+      prepend(wake, consumers_.pop());
+      return true;
+    }
+    if (items_.size() < capacity_) {
+      items_.push_back(std::move(value));
+      return true;
+    }
+    return false;
+  }
+
+  // lock held; gives the consumer up to count front values, then lets
+  // blocked producers fill the space that freed
+  void take(Waiter& consumer, size_t count, Waiter*& wake) {
+    count = std::min(count, items_.size());
+    if (count == 0) {
+      return;
+    }
+    if (consumer.batch) {
+      auto last = items_.begin();
+      std::advance(last, count);
+      consumer.nodes.splice(consumer.nodes.end(), items_, items_.begin(),
+                            last);
+    } else {
+      consumer.value.emplace(std::move(*items_.begin()));
+      items_.pop_front();
+    }
+    while (!producers_.empty() && items_.size() < capacity_) {
+      Waiter* producer = producers_.pop();
+      items_.splice(items_.end(), producer->nodes);
+      producer->accepted = true;
+      prepend(wake, producer);
+    }
+  }
+
+  class PushAwaiter {
+   private:
+    Channel* channel_;
+    T value_;
+    Waiter waiter_;
+
+   public:
+    PushAwaiter(Channel* channel, T&& value)
+        : channel_(channel),
+          value_(std::move(value)),
+          waiter_(channel->alloc_, 0, false) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      Waiter* wake = nullptr;
+      {
+        std::lock_guard<std::mutex> guard(channel_->mutex_);
+        if (!channel_->closed_) {
+          waiter_.accepted = channel_->deliver(value_, wake);
+          if (!waiter_.accepted) {
+            waiter_.nodes.push_back(std::move(value_));
+            waiter_.handle = handle;
+            channel_->producers_.push(&waiter_);
+            return true;
+          }
+        }
+      }
+      resume_all(wake);
+      return false;
+    }
+
+    // false when the channel was closed before the value got in
+    bool await_resume() noexcept { return waiter_.accepted; }
+  };
+
+  class PopAwaiter {
+   protected:
+    Channel* channel_;
+    Waiter waiter_;
+
+   public:
+    PopAwaiter(Channel* channel, size_t count, bool batch)
+        : channel_(channel), waiter_(channel->alloc_, count, batch) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+      Waiter* wake = nullptr;
+      {
+        std::lock_guard<std::mutex> guard(channel_->mutex_);
+        channel_->take(waiter_, waiter_.want, wake);
+        if (!waiter_.received() && !channel_->closed_) {
+          waiter_.handle = handle;
+          channel_->consumers_.push(&waiter_);
+          return true;
+        }
+      }
+      resume_all(wake);
+      return false;
+    }
+
+    std::optional<T> await_resume() { return std::move(waiter_.value); }
+  };
+
+  // a producer wakes a consumer with one node; the rest of the batch is
+  // collected on resumption, under a single lock
+  class PopNAwaiter : public PopAwaiter {
+   public:
+    PopNAwaiter(Channel* channel, size_t count)
+        : PopAwaiter(channel, count, true) {}
+
+    list_type await_resume() {
+      Waiter& waiter = this->waiter_;
+      if (!waiter.nodes.empty() && waiter.nodes.size() < waiter.want) {
+        Waiter* wake = nullptr;
+        {
+          std::lock_guard<std::mutex> guard(this->channel_->mutex_);
+          this->channel_->take(waiter, waiter.want - waiter.nodes.size(),
+                               wake);
+        }
+        resume_all(wake);
+      }
+      return std::move(waiter.nodes);
+    }
+  };
+
+ public:
+  // constructors; the queue reserves its sentinel and one node up front
+  explicit Channel(size_t capacity, const Allocator& alloc = Allocator())
+      : alloc_(alloc), capacity_(capacity), items_(alloc) {
+    items_.reserve(1);
+  }
+
+  Channel(const Channel&) = delete;
+  Channel& operator=(const Channel&) = delete;
+
+  // awaitables; co_await push(v) yields false once the channel is closed,
+  // co_await pop() yields std::nullopt and co_await pop_n(n) an empty List
+  // once it is closed and drained
+  PushAwaiter push(T value) { return PushAwaiter(this, std::move(value)); }
+
+  PopAwaiter pop() { return PopAwaiter(this, 1, false); }
+
+  PopNAwaiter pop_n(size_t count) { return PopNAwaiter(this, count); }
+
+  // non-suspending variants
+  bool try_push(T value) {
+    Waiter* wake = nullptr;
+    bool accepted = false;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      accepted = !closed_ && deliver(value, wake);
+    }
+    resume_all(wake);
+    return accepted;
+  }
+
+  std::optional<T> try_pop() {
+    Waiter out(alloc_, 1, false);
+    Waiter* wake = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      take(out, 1, wake);
+    }
+    resume_all(wake);
+    return std::move(out.value);
+  }
+
+  // wakes every waiter; queued values can still be popped
+  void close() {
+    Waiter* wake = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      closed_ = true;
+      while (!producers_.empty()) {
+        prepend(wake, producers_.pop());
+      }
+      while (!consumers_.empty()) {
+        prepend(wake, consumers_.pop());
+      }
+    }
+    resume_all(wake);
+  }
+
+  // getters
+  size_t size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return items_.size();
+  }
+
+  size_t capacity() const { return capacity_; }
+
+  bool closed() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return closed_;
+  }
+};
@@ -0,0 +1,46 @@
+// Tests for LIST_CHECKED_ITERATORS. The macro changes List's layout, so it
+// is its own binary: g++ -std=c++20 checked_tests.cpp -lgtest -lpthread
+#define LIST_CHECKED_ITERATORS
+#include <gtest/gtest.h>
+#include "list.hpp"
+
+TEST(CheckedIterators, ValidUseIsQuiet) {
+  List<int> lst = {1, 2, 3};
+  auto iter = ++lst.begin();
+  lst.insert(iter, 10);
+  lst.erase(lst.begin());
+  ASSERT_TRUE(*iter == 2);
+
+  List<int> other = {4, 5};
+  lst.splice(lst.end(), other, other.begin());
+  // iterators follow their elements into the list they were spliced to
+  auto moved = --lst.end();
+  lst.erase(moved);
+  ASSERT_TRUE(lst.size() == 3);
+
+  List<int> taken(std::move(lst));
+  taken.erase(iter);
+  ASSERT_TRUE(taken.size() == 2);
+}
+
+TEST(CheckedIteratorsDeathTest, CatchesMisuse) {
+  List<int> lst = {1, 2, 3};
+  ASSERT_DEATH(*lst.end(), "end\\(\\) is not dereferenceable");
+  ASSERT_DEATH(lst.erase(lst.end()), "erase: end\\(\\)");
+
+  auto iter = lst.begin();
+  lst.erase(lst.begin());
+  ASSERT_DEATH(*iter, "erased element");
+  // the freed node is reused by the next insert, the generation differs
+  lst.push_front(1);
+  ASSERT_DEATH(lst.erase(iter), "erased element");
+
+  List<int> other = {4};
+  ASSERT_DEATH(lst.erase(other.begin()), "another list");
+  ASSERT_DEATH(lst.insert(List<int>::iterator(), 0), "singular");
+}
+
+int main(int argc, char** argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
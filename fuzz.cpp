@@ -0,0 +1,378 @@
+// Differential harness: decodes a byte string into operations, applies
+// them to List and to std::list and compares the two after every step.
+//
+// libFuzzer:  clang++ -std=c++20 -g -O1 -DLIST_LIBFUZZER
+//                 -fsanitize=fuzzer,address,undefined fuzz.cpp -o fuzz
+// standalone: g++ -std=c++20 -g -O1 -fsanitize=address,undefined fuzz.cpp
+//                 -o fuzz && ./fuzz [runs] [seed]
+//             ./fuzz --replay file
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "list.hpp"
+#include "memory_utils.hpp"
+#include "utils.hpp"
+
+size_t MemoryManager::type_new_allocated = 0;
+size_t MemoryManager::type_new_deleted = 0;
+size_t MemoryManager::allocator_allocated = 0;
+size_t MemoryManager::allocator_deallocated = 0;
+size_t MemoryManager::allocator_constructed = 0;
+size_t MemoryManager::allocator_destroyed = 0;
+size_t MemoryManager::allocator_calls = 0;
+
+size_t Accountant::ctor_calls = 0;
+size_t Accountant::dtor_calls = 0;
+
+bool ThrowingAccountant::need_throw = false;
+
+namespace {
+
+const char* const kOperationNames[] = {
+    "push_back", "push_front",      "insert",      "erase",
+    "pop_back",  "pop_front",       "copy",        "assign",
+    "splice",    "splice_self",     "bulk",        "emplace_n",
+    "clear",     "reserve",         "throw_toggle", "pop_front_n",
+    "move_assign",
+};
+constexpr size_t kOperationCount = std::size(kOperationNames);
+
+struct FuzzStats {
+  size_t operations = 0;
+  size_t throws = 0;
+};
+
+FuzzStats stats;
+const uint8_t* current_data = nullptr;
+size_t current_size = 0;
+const char* current_operation = "setup";
+
+// the failing input is saved so the standalone run can be replayed
+[[noreturn]] void Fail(const char* what) {
+  std::fprintf(stderr, "fuzz: %s after %s (operation %zu)\n", what,
+               current_operation, stats.operations);
+#ifndef LIST_LIBFUZZER
+  std::ofstream out("fuzz_failure.bin", std::ios::binary);
+  out.write(reinterpret_cast<const char*>(current_data),
+            static_cast<std::streamsize>(current_size));
+  out.close();
+  std::fprintf(stderr, "fuzz: input saved to fuzz_failure.bin\n");
+#endif
+  std::abort();
+}
+
+// hands out the input bytes; reads past the end yield 0
+class FuzzInput {
+ public:
+  FuzzInput(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  bool empty() const { return pos_ >= size_; }
+
+  uint8_t byte() { return empty() ? 0 : data_[pos_++]; }
+
+  // in [0, bound]
+  size_t index(size_t bound) { return byte() % (bound + 1); }
+
+  int value() { return static_cast<int8_t>(byte()); }
+
+ private:
+  const uint8_t* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+template <class Iter>
+Iter Advance(Iter iter, size_t count) {
+  std::advance(iter, count);
+  return iter;
+}
+
+// two List/std::list pairs, so copies, assignment and splice have a partner
+template <class Alloc>
+class Harness {
+ public:
+  using list_type = List<ThrowingAccountant, Alloc>;
+
+  void run(FuzzInput& input) {
+    while (!input.empty()) {
+      uint8_t code = input.byte();
+      size_t target = code / kOperationCount % 2;
+      current_operation = kOperationNames[code % kOperationCount];
+      step(code % kOperationCount, lists_[target], expected_[target],
+           lists_[1 - target], expected_[1 - target], input);
+      ++stats.operations;
+      check();
+    }
+  }
+
+ private:
+  list_type lists_[2];
+  std::list<int> expected_[2];
+
+  // an operation that throws must leave the lists as they were, which the
+  // check after the step verifies; apply mirrors it on success only
+  template <class Operation, class Apply>
+  static void attempt(Operation&& operation, Apply&& apply) {
+    try {
+      operation();
+    } catch (const std::string&) {
+      ++stats.throws;
+      return;
+    }
+    apply();
+  }
+
+  // for operations that give only the basic guarantee
+  template <class Operation>
+  static void without_throws(Operation&& operation) {
+    bool need_throw = ThrowingAccountant::need_throw;
+    ThrowingAccountant::need_throw = false;
+    operation();
+    ThrowingAccountant::need_throw = need_throw;
+  }
+
+  static void compare(const list_type& actual, const std::list<int>& expected,
+                      const char* what) {
+    if (actual.size() != expected.size() ||
+        actual.empty() != expected.empty()) {
+      Fail(what);
+    }
+    auto iter = actual.begin();
+    for (int value : expected) {
+      if (iter == actual.end() || iter->value != value) {
+        Fail(what);
+      }
+      ++iter;
+    }
+    if (iter != actual.end()) {
+      Fail(what);
+    }
+    // the prev links must mirror the next links
+    for (auto back = expected.rbegin(); back != expected.rend(); ++back) {
+      --iter;
+      if (iter->value != *back) {
+        Fail(what);
+      }
+    }
+  }
+
+  void check() {
+    compare(lists_[0], expected_[0], "contents differ");
+    compare(lists_[1], expected_[1], "contents differ");
+    size_t live_bytes = MemoryManager::allocator_allocated -
+                        MemoryManager::allocator_deallocated;
+    if (live_bytes != lists_[0].memory_usage() + lists_[1].memory_usage()) {
+      Fail("allocator balance differs from memory_usage()");
+    }
+    if (Accountant::ctor_calls - Accountant::dtor_calls !=
+        lists_[0].size() + lists_[1].size()) {
+      Fail("constructions and destructions do not balance");
+    }
+  }
+
+  static void step(size_t operation, list_type& lst, std::list<int>& expected,
+                   list_type& other, std::list<int>& other_expected,
+                   FuzzInput& input) {
+    switch (operation) {
+      case 0: {
+        int value = input.value();
+        attempt([&] { lst.push_back(ThrowingAccountant(value)); },
+                [&] { expected.push_back(value); });
+        break;
+      }
+      case 1: {
+        int value = input.value();
+        attempt([&] { lst.push_front(ThrowingAccountant(value)); },
+                [&] { expected.push_front(value); });
+        break;
+      }
+      case 2: {
+        size_t pos = input.index(expected.size());
+        int value = input.value();
+        attempt(
+            [&] {
+              lst.insert(Advance(lst.begin(), pos), ThrowingAccountant(value));
+            },
+            [&] { expected.insert(Advance(expected.begin(), pos), value); });
+        break;
+      }
+      case 3:
+        if (!expected.empty()) {
+          size_t pos = input.index(expected.size() - 1);
+          lst.erase(Advance(lst.begin(), pos));
+          expected.erase(Advance(expected.begin(), pos));
+        }
+        break;
+      case 4:
+        if (!expected.empty()) {
+          lst.pop_back();
+          expected.pop_back();
+        }
+        break;
+      case 5:
+        if (!expected.empty()) {
+          lst.pop_front();
+          expected.pop_front();
+        }
+        break;
+      case 6:
+        attempt(
+            [&] {
+              list_type copy(lst);
+              compare(copy, expected, "copy differs");
+            },
+            [] {});
+        break;
+      case 7:
+        attempt([&] { lst = other; }, [&] { expected = other_expected; });
+        break;
+      case 8: {
+        size_t first = input.index(other_expected.size());
+        size_t last = first + input.index(other_expected.size() - first);
+        size_t pos = input.index(expected.size());
+        lst.splice(Advance(lst.begin(), pos), other,
+                   Advance(other.begin(), first), Advance(other.begin(), last));
+        expected.splice(Advance(expected.begin(), pos), other_expected,
+                        Advance(other_expected.begin(), first),
+                        Advance(other_expected.begin(), last));
+        break;
+      }
+      case 9:
+        if (!expected.empty()) {
+          size_t from = input.index(expected.size() - 1);
+          size_t pos = input.index(expected.size());
+          lst.splice(Advance(lst.begin(), pos), lst,
+                     Advance(lst.begin(), from));
+          expected.splice(Advance(expected.begin(), pos), expected,
+                          Advance(expected.begin(), from));
+        }
+        break;
+      case 10: {
+        size_t count = input.index(15);
+        std::vector<int> values;
+        for (size_t i = 0; i < count; ++i) {
+          values.push_back(input.value());
+        }
+        std::vector<ThrowingAccountant> source;
+        without_throws([&] { source.assign(values.begin(), values.end()); });
+        attempt([&] { lst.push_back_bulk(source); },
+                [&] { expected.insert(expected.end(), values.begin(),
+                                      values.end()); });
+        break;
+      }
+      case 11: {
+        size_t count = input.index(15);
+        int value = input.value();
+        attempt([&] { lst.emplace_back_n(count, value); },
+                [&] { expected.insert(expected.end(), count, value); });
+        break;
+      }
+      case 12:
+        lst.clear();
+        expected.clear();
+        break;
+      case 13:
+        lst.reserve(expected.size() + input.index(31));
+        break;
+      case 14:
+        ThrowingAccountant::need_throw = !ThrowingAccountant::need_throw;
+        break;
+      case 15: {
+        size_t count = input.index(15);
+        std::vector<ThrowingAccountant> out;
+        without_throws(
+            [&] { lst.pop_front_n(count, std::back_inserter(out)); });
+        for (const ThrowingAccountant& popped : out) {
+          if (popped.value != expected.front()) {
+            Fail("pop_front_n returned other values");
+          }
+          expected.pop_front();
+        }
+        break;
+      }
+      case 16:
+        // moves the values one by one unless the allocators compare equal
+        without_throws([&] { lst = std::move(other); });
+        expected = std::move(other_expected);
+        other_expected.clear();
+        break;
+    }
+  }
+};
+
+// the first byte picks the allocator: node by node, or runs through
+// allocate_at_least
+void RunInput(const uint8_t* data, size_t size) {
+  current_data = data;
+  current_size = size;
+  current_operation = "setup";
+  // ThrowingAccountant throws by construction count, so resetting it makes
+  // a run depend on its input alone
+  Accountant::reset();
+  ThrowingAccountant::need_throw = false;
+  size_t allocated = MemoryManager::allocator_allocated;
+  size_t deallocated = MemoryManager::allocator_deallocated;
+  FuzzInput input(data, size);
+  if (input.byte() % 2 == 0) {
+    Harness<AllocatorWithCount<ThrowingAccountant>> harness;
+    harness.run(input);
+  } else {
+    Harness<SizeClassAllocatorWithCount<ThrowingAccountant>> harness;
+    harness.run(input);
+  }
+  current_operation = "destruction";
+  if (MemoryManager::allocator_allocated - allocated !=
+          MemoryManager::allocator_deallocated - deallocated ||
+      Accountant::ctor_calls != Accountant::dtor_calls) {
+    Fail("leak");
+  }
+}
+
+}  // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  RunInput(data, size);
+  return 0;
+}
+
+#ifndef LIST_LIBFUZZER
+int main(int argc, char** argv) {
+  if (argc == 3 && std::string(argv[1]) == "--replay") {
+    std::ifstream in(argv[2], std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)),
+                              std::istreambuf_iterator<char>());
+    RunInput(data.data(), data.size());
+    std::printf("replayed %zu operations\n", stats.operations);
+    return 0;
+  }
+  size_t runs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+  uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10)
+                           : std::random_device()();
+  std::mt19937_64 random(seed);
+  std::uniform_int_distribution<size_t> length(1, 512);
+  std::vector<uint8_t> data;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t run = 0; run < runs; ++run) {
+    data.resize(length(random));
+    for (uint8_t& byte : data) {
+      byte = static_cast<uint8_t>(random());
+    }
+    RunInput(data.data(), data.size());
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::printf("seed %llu: %zu runs, %zu operations (%zu threw), %.0f ops/s\n",
+              static_cast<unsigned long long>(seed), runs, stats.operations,
+              stats.throws, stats.operations / seconds);
+  return 0;
+}
+#endif
@@ -0,0 +1,148 @@
+#pragma once
+#include <linux/mman.h>
+#include <sys/mman.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#include "slab_arena.hpp"
+
+// How the pages of a HugePageArena slab are backed.
+enum class HugePageBacking : uint8_t {
+  kNone,         // regular pages; no slab yet or huge pages unavailable
+  kTransparent,  // huge-page aligned and advised for transparent huge pages
+  kHugeTlb,      // reserved huge pages from MAP_HUGETLB
+};
+
+inline const char* HugePageBackingName(HugePageBacking backing) {
+  switch (backing) {
+    case HugePageBacking::kNone:
+      return "regular pages";
+    case HugePageBacking::kTransparent:
+      return "transparent huge pages";
+    case HugePageBacking::kHugeTlb:
+      return "MAP_HUGETLB";
+  }
+  return "unknown";
+}
+
+// Slab arena whose slabs are single 2 MB huge pages, so a list of millions
+// of nodes spans few TLB entries. A slab comes from the reserved huge page
+// pool (MAP_HUGETLB) when it has one free, otherwise from a 2 MB aligned
+// range advised with MADV_HUGEPAGE, which the kernel backs with a
+// transparent huge page if it is enabled. Where neither is available the
+// slab falls back to regular pages. Blocks too large for the size classes
+// get regular pages of their own.
+class HugePageArena : public SlabArena<HugePageArena> {
+ public:
+  static constexpr size_t kHugePageSize = 2 << 20;
+  static_assert(kHugePageSize == size_t{1} << (MAP_HUGE_2MB >> MAP_HUGE_SHIFT));
+
+  explicit HugePageArena(bool use_hugetlb = true)
+      : SlabArena(kHugePageSize), use_hugetlb_(use_hugetlb) {}
+
+  // backing of the most recent slab
+  HugePageBacking backing() const { return backing_; }
+
+ private:
+  friend class SlabArena<HugePageArena>;
+
+  bool use_hugetlb_;
+  HugePageBacking backing_ = HugePageBacking::kNone;
+
+  void* map_slab(size_t bytes) {
+    if (use_hugetlb_) {
+      // fails at once when the reserved pool has no free page; the size
+      // flag keeps a host whose default huge page is 1 GB on 2 MB pages
+      void* ptr =
+          mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2MB, -1, 0);
+      if (ptr != MAP_FAILED) {
+        backing_ = HugePageBacking::kHugeTlb;
+        return ptr;
+      }
+    }
+    // over-map, then trim to a range aligned to the huge page size
+    size_t span = bytes + kHugePageSize;
+    void* raw = mmap(nullptr, span, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    char* first = static_cast<char*>(raw);
+    char* aligned = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(first) + kHugePageSize - 1) &
+        ~(kHugePageSize - 1));
+    if (aligned > first) {
+      munmap(first, aligned - first);
+    }
+    if (aligned + bytes < first + span) {
+      munmap(aligned + bytes, first + span - (aligned + bytes));
+    }
+    backing_ = madvise(aligned, bytes, MADV_HUGEPAGE) == 0
+                   ? HugePageBacking::kTransparent
+                   : HugePageBacking::kNone;
+    return aligned;
+  }
+
+  void* map_block(size_t bytes) {
+    void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    return ptr;
+  }
+};
+
+// Allocator over a HugePageArena shared by its copies and rebinds.
+template <class T>
+class HugePageAllocator {
+ private:
+  template <class U>
+  friend class HugePageAllocator;
+
+  std::shared_ptr<HugePageArena> arena_;
+
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  // constructors
+  HugePageAllocator() : arena_(std::make_shared<HugePageArena>()) {}
+
+  explicit HugePageAllocator(std::shared_ptr<HugePageArena> arena)
+      : arena_(std::move(arena)) {}
+
+  template <class U>
+  HugePageAllocator(const HugePageAllocator<U>& other)
+      : arena_(other.arena_) {}
+
+  // methods
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    arena_->deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  // getters
+  const std::shared_ptr<HugePageArena>& arena() const { return arena_; }
+
+  template <class U>
+  bool operator==(const HugePageAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <class U>
+  bool operator!=(const HugePageAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+};
@@ -1,177 +1,377 @@
+#pragma once
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <iterator>
 #include <memory>
+#include <ranges>
+#include <span>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
-template <class T, class Allocator = std::allocator<T>>
+#include "list_trace.hpp"
+
+#ifdef LIST_CHECKED_ITERATORS
+#include "list_checks.hpp"
+#endif
+
+// Node layout policy. Specialize it with value_out_of_line = true to keep a
+// large T in its own allocation: nodes then hold only links and a pointer,
+// which pays off when traversal rarely reads the value and the node
+// allocator packs nodes densely.
+template <class T>
+struct ListNodeLayout {
+  static constexpr bool value_out_of_line = false;
+};
+
+// Tracer receives ListEvent notifications (see list_trace.hpp); the default
+// NullListTracer costs nothing.
+template <class T, class Allocator = std::allocator<T>,
+          class Tracer = ListDefaultTracer>
 class List {
  private:
+  class Node;
+
+  static constexpr bool kValueOutOfLine = ListNodeLayout<T>::value_out_of_line;
+
+ public:
+  // usings
+  using value_type = T;
+  using allocator_type = Allocator;
+  using node_allocator_type =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using node_allocator_traits =
+      typename std::allocator_traits<node_allocator_type>;
+  // may be a fancy pointer (e.g. OffsetPtr), so raw Node* is never stored
+  using node_pointer = typename node_allocator_traits::pointer;
+
+ private:
+  using value_allocator_type =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+  using value_allocator_traits = std::allocator_traits<value_allocator_type>;
+  using value_pointer = typename value_allocator_traits::pointer;
+
   // base structures
-  class Node {
+  // the union lets the sentinel and spare nodes exist as objects without a
+  // value, which constant evaluation requires; List destroys the value
+  template <bool OutOfLine, class Dummy = void>
+  class NodeValue {
    public:
-    T value;
-    Node* prev = nullptr;
-    Node* next = nullptr;
+    constexpr NodeValue() {}
 
-    Node() : value(T()) {}
+    template <class... Args>
+    constexpr explicit NodeValue(std::in_place_t, Args&&... args)
+        : value_(std::forward<Args>(args)...) {}
 
-    Node(const T& value, Node* prev = nullptr, Node* next = nullptr)
-        : prev(prev), next(next), value(value) {}
+    constexpr ~NodeValue() {}
 
-    Node(T&& value, Node* prev = nullptr, Node* next = nullptr)
-        : prev(prev), next(next), value(std::move(value)) {}
+    constexpr T& get() { return value_; }
 
-    void swap(Node& other) {
-      std::swap(*prev, *other.prev);
-      std::swap(*next, *other.next);
-      std::swap(prev->next, other.prev->next);
-      std::swap(next->prev, other.next->prev);
-      std::swap(value, other.value);
-    }
+   private:
+    union {
+      T value_;
+    };
+  };
+
+  // cold value, constructed and destroyed by List through the allocator
+  template <class Dummy>
+  class NodeValue<true, Dummy> {
+   public:
+    constexpr T& get() { return *ptr; }
+
+    value_pointer ptr = nullptr;
+  };
+
+  // allocators that declare node_runs = std::true_type hand out runs of
+  // nodes through a member allocate_at_least. A run can only be deallocated
+  // whole, so its nodes are recycled through the spare lists and the run is
+  // freed once no list holds any of them
+  static constexpr bool kAllocatesRuns =
+      requires { requires node_allocator_type::node_runs::value; };
+  static constexpr size_t kMinRun = 4;
+
+  class NodeRun;
+  using run_allocator_type =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<NodeRun>;
+  using run_allocator_traits = std::allocator_traits<run_allocator_type>;
+  using run_pointer = typename run_allocator_traits::pointer;
+
+  // the run a node's storage was carved from, present in run mode only.
+  // Node objects come and go in the same storage, so List carries the
+  // field over from one to the next
+  template <bool Runs, class Dummy = void>
+  class NodeRunRef {
+   public:
+    constexpr run_pointer get() const { return nullptr; }
+
+    constexpr void set(run_pointer) {}
+  };
+
+  template <class Dummy>
+  class NodeRunRef<true, Dummy> {
+   public:
+    constexpr run_pointer get() const { return run_; }
+
+    constexpr void set(run_pointer run) { run_ = run; }
+
+   private:
+    run_pointer run_ = nullptr;
+  };
+
+  // links come first, so traversal touches the line that also holds the
+  // start of the value; alignment of T is inherited through the value member
+  class Node {
+   public:
+    node_pointer prev = nullptr;
+    node_pointer next = nullptr;
+    NodeValue<kValueOutOfLine> slot;
+    [[no_unique_address]] NodeRunRef<kAllocatesRuns> run;
+
+    constexpr Node() = default;
+
+    template <class... Args>
+    constexpr explicit Node(std::in_place_t, Args&&... args)
+        : slot(std::in_place, std::forward<Args>(args)...) {}
+
+    constexpr T& value() { return slot.get(); }
   };
 
   class BaseNode {
    public:
-    Node* base = nullptr;
+    node_pointer base = nullptr;
   };
 
- public:
-  // usings
-  using value_type = T;
-  using allocator_type = Allocator;
-  using node_allocator_type =
-      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
-  using node_allocator_traits =
-      typename std::allocator_traits<node_allocator_type>;
+  // trivially copyable values are copied into fresh nodes with memcpy,
+  // unless the allocator wants to construct them itself
+  static constexpr bool kMemcpyValues =
+      !kValueOutOfLine && std::is_trivially_copyable_v<T> &&
+      !requires(node_allocator_type& alloc, Node* node, const T& value) {
+        alloc.construct(node, std::in_place, value);
+      };
+
+  // nodes leave their run's list through splice, so a run counts the nodes
+  // any list still holds, as element, sentinel or spare
+  class NodeRun {
+   public:
+    node_pointer first = nullptr;
+    size_t count = 0;
+    size_t held = 0;
+    // list whose runs_ chain has the run; null once that list is gone
+    List* owner = nullptr;
+    run_pointer next = nullptr;
+  };
 
  private:
   node_allocator_type node_alloc_;
   BaseNode root_;
   size_t size_ = 0;
+  // unconstructed node storage linked through next, kept while the list
+  // holds fewer than reserved_ nodes (for runs, until the list is empty)
+  node_pointer spare_ = nullptr;
+  size_t spare_count_ = 0;
+  size_t reserved_ = 0;
+  // runs this list allocated
+  run_pointer runs_ = nullptr;
+  // nodes in all runs_, which sets the size of the next one
+  size_t run_nodes_ = 0;
+  // nodes held here from runs of other lists, spliced in
+  size_t borrowed_ = 0;
+
+ public:
+  // node layout, used to size external node storage
+  static constexpr size_t node_size = sizeof(Node);
+  static constexpr size_t node_alignment = alignof(Node);
 
  public:
   // iterator
   template <bool IsConst>
-  class Iterator : public std::iterator<
-                       std::bidirectional_iterator_tag,
-                       typename std::conditional<IsConst, const T, T>::type> {
+  class Iterator {
    private:
-    Node* itptr_ = nullptr;
+    node_pointer itptr_ = nullptr;
+#ifdef LIST_CHECKED_ITERATORS
+    // generation of the node when the iterator reached it
+    uint64_t generation_ = 0;
+#endif
+
+    friend class List;
+    template <bool>
+    friend class Iterator;
+
+    constexpr void check([[maybe_unused]] bool need_value,
+                         [[maybe_unused]] const char* operation) const {
+#ifdef LIST_CHECKED_ITERATORS
+      if (!std::is_constant_evaluated()) {
+        ListIteratorRegistry::check(std::to_address(itptr_), generation_,
+                                    nullptr, need_value, operation);
+      }
+#endif
+    }
+
+    constexpr void refresh() {
+#ifdef LIST_CHECKED_ITERATORS
+      if (!std::is_constant_evaluated()) {
+        generation_ =
+            ListIteratorRegistry::generation_of(std::to_address(itptr_));
+      }
+#endif
+    }
 
    public:
-    typedef typename std::conditional<IsConst, const T, T>::type Ttype;
-    using value_type = typename std::iterator<std::bidirectional_iterator_tag,
-                                              Ttype>::value_type;
-    using pointer =
-        typename std::iterator<std::bidirectional_iterator_tag, Ttype>::pointer;
-    using difference_type =
-        typename std::iterator<std::bidirectional_iterator_tag,
-                               Ttype>::difference_type;
-    using reference = typename std::iterator<std::bidirectional_iterator_tag,
-                                             Ttype>::reference;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using value_type = std::remove_cv_t<T>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const T*, T*>;
+    using reference = std::conditional_t<IsConst, const T&, T&>;
 
     // constructors and destructor
-    Iterator() = default;
+    constexpr Iterator() = default;
 
-    Iterator(Node* ptr) : itptr_(ptr){};
+    constexpr Iterator(node_pointer ptr) : itptr_(ptr) { refresh(); }
 
-    Iterator(const Iterator<IsConst>& copy) : itptr_(copy.itptr_) {}
+    constexpr Iterator(const Iterator<IsConst>& copy) = default;
+
+    // iterator converts to const_iterator, not the other way round
+    constexpr Iterator(const Iterator<false>& other)
+      requires IsConst
+        : itptr_(other.itptr_) {
+      refresh();
+    }
 
-    ~Iterator() = default;
+    constexpr ~Iterator() = default;
 
     // operators
-    void operator=(const Iterator& copy) { itptr_ = copy.itptr_; }
+    constexpr Iterator& operator=(const Iterator& copy) = default;
 
-    reference operator*() const { return itptr_->value; }
+    constexpr reference operator*() const {
+      check(true, "dereference");
+      return itptr_->value();
+    }
 
-    pointer operator->() const { return &(itptr_->value); }
+    constexpr pointer operator->() const {
+      check(true, "dereference");
+      return &(itptr_->value());
+    }
 
-    Iterator<IsConst>& operator++() {
+    constexpr Iterator<IsConst>& operator++() {
+      check(false, "increment");
       itptr_ = itptr_->next;
+      refresh();
       return *this;
     }
 
-    Iterator<IsConst> operator++(int) {
+    constexpr Iterator<IsConst> operator++(int) {
       Iterator<IsConst> temp(*this);
       ++(*this);
       return temp;
     }
 
-    Iterator<IsConst>& operator--() {
+    constexpr Iterator<IsConst>& operator--() {
+      check(false, "decrement");
       itptr_ = itptr_->prev;
+      refresh();
       return *this;
     }
 
-    Iterator<IsConst> operator--(int) {
+    constexpr Iterator<IsConst> operator--(int) {
       Iterator<IsConst> temp(*this);
       --(*this);
       return temp;
     }
 
-    bool operator==(const Iterator<IsConst>& other) const {
+    constexpr bool operator==(const Iterator<IsConst>& other) const {
       return itptr_ == other.itptr_;
     }
 
-    bool operator!=(const Iterator<IsConst>& other) const {
+    constexpr bool operator!=(const Iterator<IsConst>& other) const {
       return itptr_ != other.itptr_;
     }
 
-    Node* get_ptr() { return itptr_; }
+    constexpr node_pointer get_ptr() const { return itptr_; }
   };
 
   // methods
-  void insert(Iterator<false> iter, const T& value) {
-    Node* temp = construct_node(value);
-    try {
-      temp->next = iter.get_ptr();
-      --iter;
-      temp->prev = iter.get_ptr();
-      temp->next->prev = temp;
-      temp->prev->next = temp;
-      ++size_;
-    } catch (...) {
-      throw;
+  constexpr void insert(Iterator<false> iter, const T& value) {
+    insert_node(iter, value);
+  }
+
+  constexpr void insert(Iterator<false> iter, T&& value) {
+    insert_node(iter, std::move(value));
+  }
+
+  constexpr void insert(Iterator<false> iter) { insert_node(iter); }
+
+  constexpr void erase(Iterator<false> iter) {
+    trace(ListEvent::kErase, 1);
+    check_iterator(iter, true, "erase");
+    node_pointer temp = iter.get_ptr();
+    temp->next->prev = temp->prev;
+    temp->prev->next = temp->next;
+    --size_;
+    destroy_node(temp);
+    release_base_node_if_empty();
+  }
+
+  // splice methods relink nodes without copying or reallocating them, so
+  // other must use an allocator that compares equal to ours
+  constexpr void splice(Iterator<false> pos, List& other,
+                        Iterator<false> first, Iterator<false> last) {
+    if (other.root_.base != nullptr) {
+      check_iterator(last, false, "splice", &other);
+    }
+    if (first == last) {
+      return;
+    }
+    check_iterator(first, true, "splice", &other);
+    if (root_.base != nullptr) {
+      check_iterator(pos, false, "splice");
+    }
+    node_pointer head = first.get_ptr();
+    node_pointer tail = last.get_ptr()->prev;
+    if (this == &other) {
+      unlink_range(head, tail, 0);
+      link_range(pos.get_ptr(), head, tail, 0);
+      return;
     }
+    size_t count = count_spliced(other, head, last.get_ptr());
+    node_pointer target = splice_target(pos);
+    other.unlink_range(head, tail, count);
+    other.release_base_node_if_empty();
+    link_range(target, head, tail, count);
+    retrack_range(head, target);
   }
 
-  void insert(Iterator<false> iter) {
-    Node* temp = node_allocator_traits::allocate(node_alloc_, 1);
-    try {
-      node_allocator_traits::construct(node_alloc_, temp);
-    } catch (...) {
-      node_allocator_traits::deallocate(node_alloc_, temp, 1);
-      throw;
+  constexpr void splice(Iterator<false> pos, List& other,
+                        Iterator<false> iter) {
+    check_iterator(iter, true, "splice", &other);
+    if (root_.base != nullptr) {
+      check_iterator(pos, false, "splice");
     }
-    try {
-      temp->next = iter.get_ptr();
-      --iter;
-      temp->prev = iter.get_ptr();
-      temp->next->prev = temp;
-      temp->prev->next = temp;
-      ++size_;
-    } catch (...) {
-      throw;
+    Iterator<false> next = iter;
+    ++next;
+    if (this == &other && (pos == iter || pos == next)) {
+      return;
     }
+    if (this != &other) {
+      node_pointer node = iter.get_ptr();
+      count_spliced(other, node, next.get_ptr());
+      node_pointer target = splice_target(pos);
+      other.unlink_range(node, node, 1);
+      other.release_base_node_if_empty();
+      link_range(target, node, node, 1);
+      retrack_range(node, target);
+      return;
+    }
+    splice(pos, other, iter, next);
   }
 
-  void erase(Iterator<false> iter) {
-    Node* temp = iter.get_ptr();
-    try {
-      temp->next->prev = temp->prev;
-      temp->prev->next = temp->next;
-      node_allocator_traits::destroy(node_alloc_, temp);
-      node_allocator_traits::deallocate(node_alloc_, temp, 1);
-      --size_;
-      if (empty()) {
-        node_allocator_traits::deallocate(node_alloc_, root_.base, 1);
-        root_.base = nullptr;
-      }
-    } catch (...) {
-      throw;
+  constexpr void splice(Iterator<false> pos, List& other) {
+    if (this != &other && !other.empty()) {
+      splice(pos, other, other.begin(), other.end());
     }
   }
 
@@ -181,220 +381,932 @@ class List {
   using reverse_iterator = std::reverse_iterator<iterator>;
   using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-  iterator begin() { return iterator(root_.base->next); }
+  // an empty list has no sentinel, and begin() == end() is null
+  constexpr iterator begin() { return iterator(first_node()); }
+
+  constexpr iterator end() { return iterator(root_.base); }
+
+  constexpr const_iterator begin() const {
+    return const_iterator(first_node());
+  }
 
-  iterator end() { return iterator(root_.base); }
+  constexpr const_iterator end() const { return const_iterator(root_.base); }
 
-  iterator begin() const { return iterator(root_.base->next); }
+  constexpr const_iterator cbegin() { return const_iterator(first_node()); }
 
-  iterator end() const { return iterator(root_.base); }
+  constexpr const_iterator cend() { return const_iterator(root_.base); }
 
-  const_iterator cbegin() { return const_iterator(root_.base->next); }
+  constexpr const_iterator cbegin() const {
+    return const_iterator(first_node());
+  }
 
-  const_iterator cend() { return const_iterator(root_.base); }
+  constexpr const_iterator cend() const { return const_iterator(root_.base); }
 
-  const_iterator cbegin() const { return const_iterator(root_.base->next); }
+  constexpr reverse_iterator rbegin() { return reverse_iterator(end()); }
 
-  const_iterator cend() const { return const_iterator(root_.base); }
+  constexpr reverse_iterator rend() { return reverse_iterator(begin()); }
 
-  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  constexpr const_reverse_iterator rbegin() const {
+    return const_reverse_iterator(end());
+  }
 
-  reverse_iterator rend() { return reverse_iterator(begin()); }
+  constexpr const_reverse_iterator rend() const {
+    return const_reverse_iterator(begin());
+  }
 
-  const_reverse_iterator crbegin() { return const_reverse_iterator(cend()); }
+  constexpr const_reverse_iterator crbegin() const {
+    return const_reverse_iterator(cend());
+  }
 
-  const_reverse_iterator crend() { return const_reverse_iterator(cbegin()); }
+  constexpr const_reverse_iterator crend() const {
+    return const_reverse_iterator(cbegin());
+  }
 
  private:
-  // base structure constructor/destructor
-  Node* allocate_base_node() {
-    Node* node = node_allocator_traits::allocate(node_alloc_, 1);
+  constexpr node_pointer first_node() const {
+    return root_.base == nullptr ? nullptr : root_.base->next;
+  }
+
+  // tracers are runtime only, so constant evaluation skips them
+  constexpr void trace(ListEvent event, size_t count) {
+    if (!std::is_constant_evaluated()) {
+      Tracer::record(event, this, count);
+    }
+  }
+
+  // checked iterators: nodes are registered with their owner while live
+  constexpr void check_iterator(
+      [[maybe_unused]] Iterator<false> iter, [[maybe_unused]] bool need_value,
+      [[maybe_unused]] const char* operation,
+      [[maybe_unused]] const List* owner = nullptr) const {
+#ifdef LIST_CHECKED_ITERATORS
+    if (!std::is_constant_evaluated()) {
+      ListIteratorRegistry::check(std::to_address(iter.itptr_),
+                                  iter.generation_, owner ? owner : this,
+                                  need_value, operation);
+    }
+#endif
+  }
+
+  constexpr void track_node([[maybe_unused]] node_pointer node,
+                            [[maybe_unused]] bool sentinel) {
+#ifdef LIST_CHECKED_ITERATORS
+    if (!std::is_constant_evaluated()) {
+      ListIteratorRegistry::add(std::to_address(node), this, sentinel);
+    }
+#endif
+  }
+
+  constexpr void untrack_node([[maybe_unused]] node_pointer node) {
+#ifdef LIST_CHECKED_ITERATORS
+    if (!std::is_constant_evaluated()) {
+      ListIteratorRegistry::remove(std::to_address(node));
+    }
+#endif
+  }
+
+  // claims the nodes from first up to, not including, stop
+  constexpr void retrack_range([[maybe_unused]] node_pointer first,
+                               [[maybe_unused]] node_pointer stop) {
+#ifdef LIST_CHECKED_ITERATORS
+    if (!std::is_constant_evaluated()) {
+      for (node_pointer node = first; node != stop; node = node->next) {
+        ListIteratorRegistry::set_owner(std::to_address(node), this);
+      }
+    }
+#endif
+  }
+
+  constexpr void retrack_all() {
+    if (root_.base != nullptr) {
+      retrack_range(root_.base->next, root_.base);
+#ifdef LIST_CHECKED_ITERATORS
+      if (!std::is_constant_evaluated()) {
+        ListIteratorRegistry::set_owner(std::to_address(root_.base), this);
+      }
+#endif
+    }
+  }
+
+  // base structure constructor/destructor; the sentinel is a Node without
+  // a value
+  constexpr node_pointer allocate_base_node() {
+    trace(ListEvent::kAllocateBaseNode, 1);
+    auto [node, run] = acquire_node_storage();
+    std::construct_at(std::to_address(node));
+    node->run.set(run);
     node->prev = node;
     node->next = node;
+    track_node(node, true);
     return node;
   }
 
-  Node* construct_node(const T& value) {
-    Node* node = node_allocator_traits::allocate(node_alloc_, 1);
+  template <class... Args>
+  constexpr node_pointer construct_node(Args&&... args) {
+    trace(ListEvent::kConstructNode, 1);
+    auto [node, run] = acquire_node_storage();
+    if constexpr (kValueOutOfLine) {
+      std::construct_at(std::to_address(node));
+      value_allocator_type value_alloc(node_alloc_);
+      value_pointer value = nullptr;
+      try {
+        value = value_allocator_traits::allocate(value_alloc, 1);
+        value_allocator_traits::construct(value_alloc, std::to_address(value),
+                                          std::forward<Args>(args)...);
+      } catch (...) {
+        if (value != nullptr) {
+          value_allocator_traits::deallocate(value_alloc, value, 1);
+        }
+        std::destroy_at(std::to_address(node));
+        release_node_storage(node, run);
+        throw;
+      }
+      node->slot.ptr = value;
+    } else {
+      try {
+        node_allocator_traits::construct(node_alloc_, std::to_address(node),
+                                         std::in_place,
+                                         std::forward<Args>(args)...);
+      } catch (...) {
+        release_node_storage(node, run);
+        throw;
+      }
+    }
+    node->run.set(run);
+    track_node(node, false);
+    return node;
+  }
+
+  constexpr void destroy_node(node_pointer node) {
+    untrack_node(node);
+    run_pointer run = node->run.get();
+    if constexpr (kValueOutOfLine) {
+      value_allocator_type value_alloc(node_alloc_);
+      value_allocator_traits::destroy(value_alloc,
+                                      std::to_address(node->slot.ptr));
+      value_allocator_traits::deallocate(value_alloc, node->slot.ptr, 1);
+      std::destroy_at(std::to_address(node));
+    } else {
+      std::destroy_at(std::addressof(node->value()));
+      node_allocator_traits::destroy(node_alloc_, std::to_address(node));
+    }
+    release_node_storage(node, run);
+  }
+
+  // node storage, for elements and the sentinel alike; storage handed out
+  // holds no object, while spares are kept as empty Nodes
+  class NodeStorage {
+   public:
+    node_pointer node;
+    // null outside run mode
+    run_pointer run;
+  };
+
+  constexpr NodeStorage acquire_node_storage() {
+    if (spare_ == nullptr) {
+      if constexpr (kAllocatesRuns) {
+        // grow by half, so the run records stay few as the list grows,
+        // also while a detached chain is built before size_ counts it
+        allocate_run(std::max<size_t>(run_nodes_ / 2, kMinRun));
+      } else {
+        return {node_allocator_traits::allocate(node_alloc_, 1), nullptr};
+      }
+    }
+    node_pointer node = spare_;
+    run_pointer run = node->run.get();
+    spare_ = node->next;
+    --spare_count_;
+    std::destroy_at(std::to_address(node));
+    return {node, run};
+  }
+
+  constexpr void push_spare(node_pointer node, run_pointer run) {
+    std::construct_at(std::to_address(node));
+    node->run.set(run);
+    node->next = spare_;
+    spare_ = node;
+    ++spare_count_;
+  }
+
+  // the caller has already dropped node from size_ or root_
+  constexpr void release_node_storage(node_pointer node, run_pointer run) {
+    size_t held = size_ + spare_count_ + (root_.base != nullptr ? 1 : 0);
+    if (kAllocatesRuns || held < reserved_) {
+      push_spare(node, run);
+      return;
+    }
+    node_allocator_traits::deallocate(node_alloc_, node, 1);
+  }
+
+  // asks for at least count nodes and adds every node received to the
+  // spare list
+  constexpr void allocate_run(size_t count) {
+    auto [first, received] = node_alloc_.allocate_at_least(count);
+    run_allocator_type run_alloc(node_alloc_);
+    run_pointer run = nullptr;
     try {
-      node_allocator_traits::construct(node_alloc_, node, value);
+      run = run_allocator_traits::allocate(run_alloc, 1);
     } catch (...) {
-      node_allocator_traits::deallocate(node_alloc_, node, 1);
+      node_allocator_traits::deallocate(node_alloc_, first, received);
       throw;
     }
-    return node;
+    std::construct_at(std::to_address(run));
+    run->first = first;
+    run->count = received;
+    run->held = received;
+    adopt_run(run);
+    for (size_t i = received; i > 0; --i) {
+      push_spare(first + (i - 1), run);
+    }
+  }
+
+  constexpr void adopt_run(run_pointer run) {
+    run->owner = this;
+    run->next = runs_;
+    runs_ = run;
+    run_nodes_ += run->count;
+  }
+
+  constexpr void free_run(run_pointer run) {
+    run_allocator_type run_alloc(node_alloc_);
+    node_allocator_traits::deallocate(node_alloc_, run->first, run->count);
+    std::destroy_at(std::to_address(run));
+    run_allocator_traits::deallocate(run_alloc, run, 1);
+  }
+
+  // gives spares back and frees the runs none of whose nodes a list holds
+  // any more; an orphaned run whose last nodes were ours is freed too. A
+  // list that stays keeps spares of runs other lists still use; one that
+  // goes away leaves such runs to those lists
+  constexpr void release_runs(bool staying) {
+    // nothing borrowed and no node of our runs held elsewhere: every run is
+    // free, and the spares need no walk
+    size_t held = 0;
+    for (run_pointer run = runs_; run != nullptr; run = run->next) {
+      held += run->held;
+    }
+    if (borrowed_ == 0 && held == spare_count_) {
+      while (runs_ != nullptr) {
+        run_pointer run = runs_;
+        runs_ = run->next;
+        free_run(run);
+      }
+      spare_ = nullptr;
+      spare_count_ = 0;
+      run_nodes_ = 0;
+      return;
+    }
+    for (node_pointer node = spare_; node != nullptr; node = node->next) {
+      --node->run.get()->held;
+    }
+    // a run's nodes are all kept or all dropped: held is 0 for the dropped
+    // ones and stays so, and the first kept node makes it positive
+    node_pointer kept = nullptr;
+    size_t kept_count = 0;
+    size_t borrowed = 0;
+    for (node_pointer node = spare_; node != nullptr;) {
+      node_pointer next = node->next;
+      run_pointer run = node->run.get();
+      if (run->held == 0 && run->owner == nullptr) {
+        adopt_run(run);
+      }
+      if (staying && (run->held > 0 || run->owner != this)) {
+        ++run->held;
+        node->next = kept;
+        kept = node;
+        ++kept_count;
+        borrowed += run->owner != this ? 1 : 0;
+      } else {
+        std::destroy_at(std::to_address(node));
+      }
+      node = next;
+    }
+    spare_ = kept;
+    spare_count_ = kept_count;
+    borrowed_ = borrowed;
+    run_pointer shared = nullptr;
+    while (runs_ != nullptr) {
+      run_pointer run = runs_;
+      runs_ = run->next;
+      if (run->held == 0) {
+        run_nodes_ -= run->count;
+        free_run(run);
+      } else if (staying) {
+        run->next = shared;
+        shared = run;
+      } else {
+        run_nodes_ -= run->count;
+        run->owner = nullptr;
+      }
+    }
+    runs_ = shared;
+  }
+
+  // returns all spare storage to the allocator as the list goes away
+  constexpr void release_spares() {
+    if constexpr (kAllocatesRuns) {
+      release_runs(false);
+    } else {
+      for (node_pointer node = spare_; node != nullptr;) {
+        node_pointer next = node->next;
+        std::destroy_at(std::to_address(node));
+        node_allocator_traits::deallocate(node_alloc_, node, 1);
+        node = next;
+      }
+      spare_ = nullptr;
+      spare_count_ = 0;
+    }
+    reserved_ = 0;
+  }
+
+  // gives back the spares of an empty list that stays alive
+  constexpr void trim_spares() {
+    reserved_ = 0;
+    if constexpr (kAllocatesRuns) {
+      if (spare_ != nullptr) {
+        release_runs(true);
+      }
+    } else {
+      release_spares();
+    }
+  }
+
+  constexpr void swap_storage(List& other) {
+    std::swap(root_, other.root_);
+    std::swap(size_, other.size_);
+    std::swap(spare_, other.spare_);
+    std::swap(spare_count_, other.spare_count_);
+    std::swap(reserved_, other.reserved_);
+    std::swap(runs_, other.runs_);
+    std::swap(run_nodes_, other.run_nodes_);
+    std::swap(borrowed_, other.borrowed_);
+    for (run_pointer run = runs_; run != nullptr; run = run->next) {
+      run->owner = this;
+    }
+    for (run_pointer run = other.runs_; run != nullptr; run = run->next) {
+      run->owner = &other;
+    }
+  }
+
+  constexpr node_pointer construct_copy(const T& value) {
+    if constexpr (kMemcpyValues) {
+      if (!std::is_constant_evaluated()) {
+        trace(ListEvent::kConstructNode, 1);
+        auto [node, run] = acquire_node_storage();
+        std::construct_at(std::to_address(node));
+        node->run.set(run);
+        std::memcpy(static_cast<void*>(std::addressof(node->value())),
+                    std::addressof(value), sizeof(T));
+        track_node(node, false);
+        return node;
+      }
+    }
+    return construct_node(value);
+  }
+
+  // bulk helpers: a chain is a detached run of nodes linked through next
+  // and terminated by nullptr
+  constexpr void destroy_chain(node_pointer first) {
+    while (first != nullptr) {
+      node_pointer next = first->next;
+      destroy_node(first);
+      first = next;
+    }
+  }
+
+  // builds the whole chain before touching the list, so a throwing
+  // make_node leaves *this unchanged
+  template <class MakeNode>
+  constexpr void append_chain(size_t count, MakeNode&& make_node) {
+    if constexpr (kAllocatesRuns) {
+      // one run for the whole chain, without raising reserved_
+      size_t needed = count + (root_.base == nullptr ? 1 : 0);
+      if (spare_count_ < needed) {
+        allocate_run(needed - spare_count_);
+      }
+    }
+    size_t index = 0;
+    append_nodes([&]() -> node_pointer {
+      return index < count ? make_node(index++) : nullptr;
+    });
   }
 
-  Node* construct_node(T&& value) {
-    Node* node = node_allocator_traits::allocate(node_alloc_, 1);
+  // as append_chain, for a source of unknown length: make_node returns
+  // nullptr once it is exhausted
+  template <class MakeNode>
+  constexpr void append_nodes(MakeNode&& make_node) {
+    node_pointer first = nullptr;
+    node_pointer last = nullptr;
+    size_t count = 0;
     try {
-      node_allocator_traits::construct(node_alloc_, node, std::move(value));
+      for (node_pointer node = make_node(); node != nullptr;
+           node = make_node()) {
+        node->prev = last;
+        node->next = nullptr;
+        if (last == nullptr) {
+          first = node;
+        } else {
+          last->next = node;
+        }
+        last = node;
+        ++count;
+      }
+      if (first == nullptr) {
+        return;
+      }
+      if (root_.base == nullptr) {
+        root_.base = allocate_base_node();
+      }
     } catch (...) {
-      node_allocator_traits::deallocate(node_alloc_, node, 1);
+      destroy_chain(first);
+      release_base_node_if_empty();
+      throw;
     }
-    return node;
+    link_range(root_.base, first, last, count);
   }
 
- public:
-  void push_back(const T& value) {
-    if (empty()) {
-      root_.base = allocate_base_node();
-      Node* temp = construct_node(value);
-      temp->prev = root_.base;
-      temp->prev->next = temp;
-      temp->next = root_.base;
-      temp->next->prev = temp;
-      ++size_;
+  // appends copies of another list's elements, allocator types aside
+  template <class Source>
+  constexpr void append_copies(const Source& source) {
+    if (source.empty()) {
       return;
     }
-    insert(end(), value);
+    auto iter = source.cbegin();
+    append_chain(source.size(),
+                 [&](size_t) { return construct_copy(*iter++); });
   }
 
-  void push_back(T&& value) {
-    if (empty()) {
-      root_.base = allocate_base_node();
-      Node* temp = construct_node(std::move(value));
-      temp->prev = root_.base;
-      temp->prev->next = temp;
-      temp->next = root_.base;
-      temp->next->prev = temp;
-      ++size_;
-      return;
+  // the new elements are linked in one step before the old ones go, so a
+  // throwing copy leaves *this unchanged
+  template <class Source>
+  constexpr void assign_copies(const Source& source) {
+    size_t prev_size = size_;
+    append_copies(source);
+    for (; prev_size > 0; --prev_size) {
+      pop_front();
     }
-    insert(end(), value);
   }
 
-  void emplace_back() {
-    if (empty()) {
+  // links the detached run [first, last] of count nodes in front of pos
+  constexpr void link_range(node_pointer pos, node_pointer first,
+                            node_pointer last, size_t count) {
+    first->prev = pos->prev;
+    last->next = pos;
+    pos->prev->next = first;
+    pos->prev = last;
+    size_ += count;
+  }
+
+  // detaches [first, last]; the caller relinks or frees the run
+  constexpr void unlink_range(node_pointer first, node_pointer last,
+                              size_t count) {
+    first->prev->next = last->next;
+    last->next->prev = first->prev;
+    size_ -= count;
+  }
+
+  // end() of an empty list has no sentinel yet, so splicing into it
+  // allocates one first; this is the only step of a splice that can throw
+  constexpr node_pointer splice_target(Iterator<false> pos) {
+    if (root_.base == nullptr) {
       root_.base = allocate_base_node();
+      return root_.base;
     }
-    insert(end());
+    return pos.get_ptr();
   }
 
-  void push_front(const T& value) { insert(begin(), value); }
+  // counts the nodes from first up to stop that move here from other, and
+  // with runs, which of them each list holds from a run not its own
+  constexpr size_t count_spliced(List& other, node_pointer first,
+                                 node_pointer stop) {
+    size_t count = 0;
+    for (node_pointer node = first; node != stop; node = node->next) {
+      ++count;
+      if constexpr (kAllocatesRuns) {
+        List* owner = node->run.get()->owner;
+        other.borrowed_ -= owner != &other ? 1 : 0;
+        borrowed_ += owner != this ? 1 : 0;
+      }
+    }
+    return count;
+  }
 
-  void pop_back() {
+  // end() of an empty list is the null iterator; inserting there creates
+  // the sentinel, which goes again if the element cannot be constructed
+  template <class... Args>
+  constexpr void insert_node(Iterator<false> iter, Args&&... args) {
+    if (root_.base != nullptr) {
+      check_iterator(iter, false, "insert");
+    }
+    node_pointer target = splice_target(iter);
+    node_pointer temp = nullptr;
+    try {
+      temp = construct_node(std::forward<Args>(args)...);
+    } catch (...) {
+      release_base_node_if_empty();
+      throw;
+    }
+    link_range(target, temp, temp, 1);
+  }
+
+  // an empty list without a reserve also gives its runs back
+  constexpr void release_base_node_if_empty() {
+    if (!empty()) {
+      return;
+    }
+    if (root_.base != nullptr) {
+      node_pointer base = root_.base;
+      run_pointer run = base->run.get();
+      root_.base = nullptr;
+      untrack_node(base);
+      std::destroy_at(std::to_address(base));
+      release_node_storage(base, run);
+    }
+    if constexpr (kAllocatesRuns) {
+      if (reserved_ == 0 && spare_ != nullptr) {
+        release_runs(true);
+      }
+    }
+  }
+
+ public:
+  constexpr void push_back(const T& value) { insert(end(), value); }
+
+  constexpr void push_back(T&& value) { insert(end(), std::move(value)); }
+
+  constexpr void emplace_back() { insert(end()); }
+
+  constexpr void push_front(const T& value) { insert(begin(), value); }
+
+  constexpr void pop_back() {
     auto iter = end();
     --iter;
     erase(iter);
   }
 
-  void pop_front() { erase(begin()); }
+  constexpr void pop_front() { erase(begin()); }
 
-  void clear() {
+  constexpr void clear() {
     while (size_ > 0) {
       pop_front();
     }
   }
 
+  // makes room for count elements, so inserts up to that size allocate
+  // nothing. With a run allocator the missing nodes are requested at once.
+  constexpr void reserve(size_t count) {
+    if (count == 0) {
+      return;
+    }
+    size_t prev_reserved = reserved_;
+    reserved_ = std::max(reserved_, count + 1);
+    size_t held = size_ + spare_count_ + (root_.base != nullptr ? 1 : 0);
+    if (held >= reserved_) {
+      return;
+    }
+    try {
+      if constexpr (kAllocatesRuns) {
+        allocate_run(reserved_ - held);
+      } else {
+        for (; held < reserved_; ++held) {
+          push_spare(node_allocator_traits::allocate(node_alloc_, 1), nullptr);
+        }
+      }
+    } catch (...) {
+      // a failed reserve keeps neither the new target nor its nodes
+      reserved_ = prev_reserved;
+      if constexpr (!kAllocatesRuns) {
+        for (; held > prev_reserved && spare_ != nullptr; --held) {
+          node_allocator_traits::deallocate(node_alloc_,
+                                            acquire_node_storage().node, 1);
+        }
+      }
+      throw;
+    }
+  }
+
+  // bulk methods
+  constexpr void push_back_bulk(std::span<const T> values) {
+    if (values.empty()) {
+      return;
+    }
+    append_chain(values.size(),
+                 [&](size_t i) { return construct_node(values[i]); });
+  }
+
+  template <class... Args>
+  constexpr void emplace_back_n(size_t count, const Args&... args) {
+    if (count == 0) {
+      return;
+    }
+    append_chain(count, [&](size_t) { return construct_node(args...); });
+  }
+
+  // appends a range in one step, e.g. the result of a views pipeline: the
+  // nodes are built first, so a throwing element leaves *this unchanged,
+  // and a sized range is allocated up front as in push_back_bulk
+  template <std::ranges::input_range Range>
+  constexpr void append_range(Range&& range) {
+    using reference = std::ranges::range_reference_t<Range>;
+    auto iter = std::ranges::begin(range);
+    auto stop = std::ranges::end(range);
+    auto make_node = [&]() -> node_pointer {
+      node_pointer node = nullptr;
+      if constexpr (std::is_same_v<reference, const T&> ||
+                    std::is_same_v<reference, T&>) {
+        node = construct_copy(*iter);
+      } else {
+        node = construct_node(*iter);
+      }
+      ++iter;
+      return node;
+    };
+    if constexpr (std::ranges::sized_range<Range>) {
+      append_chain(std::ranges::size(range),
+                   [&](size_t) { return make_node(); });
+    } else {
+      append_nodes([&]() -> node_pointer {
+        if (iter == stop) {
+          return nullptr;
+        }
+        return make_node();
+      });
+    }
+  }
+
+  // moves up to count front elements into out and unlinks them at once
+  template <class OutputIt>
+  constexpr OutputIt pop_front_n(size_t count, OutputIt out) {
+    count = std::min(count, size_);
+    if (count == 0) {
+      return out;
+    }
+    trace(ListEvent::kErase, count);
+    node_pointer first = root_.base->next;
+    node_pointer last = first;
+    for (size_t i = 1;; ++i) {
+      *out = std::move(last->value());
+      ++out;
+      if (i == count) {
+        break;
+      }
+      last = last->next;
+    }
+    root_.base->next = last->next;
+    last->next->prev = root_.base;
+    last->next = nullptr;
+    size_ -= count;
+    destroy_chain(first);
+    release_base_node_if_empty();
+    return out;
+  }
+
   // constructors
-  explicit List(Allocator alloc = Allocator()) : node_alloc_(alloc) {}
+  constexpr explicit List(Allocator alloc = Allocator()) : node_alloc_(alloc) {}
 
-  explicit List(size_t count, Allocator alloc = Allocator()) try
+  constexpr explicit List(size_t count, Allocator alloc = Allocator())
       : node_alloc_(alloc) {
-    for (size_t i = 0; i < count; ++i) {
-      try {
+    try {
+      for (size_t i = 0; i < count; ++i) {
         emplace_back();
-      } catch (...) {
-        clear();
-        throw;
       }
+    } catch (...) {
+      clear();
+      release_spares();
+      throw;
     }
-  } catch (...) {
-    throw;
   }
 
-  List(std::initializer_list<T> init, const Allocator& alloc = Allocator()) try
+  constexpr List(std::initializer_list<T> init,
+                 const Allocator& alloc = Allocator())
       : node_alloc_(alloc) {
-    auto iter = init.begin();
-    while (iter != init.end()) {
-      push_back(*(iter++));
+    try {
+      for (const T& value : init) {
+        push_back(value);
+      }
+    } catch (...) {
+      clear();
+      release_spares();
+      throw;
     }
-  } catch (...) {
-    throw;
   }
 
-  // ok
-  List(size_t count, const T& value, const Allocator& alloc = Allocator()) try
+  constexpr List(size_t count, const T& value,
+                 const Allocator& alloc = Allocator())
       : node_alloc_(alloc) {
-    for (size_t i = 0; i < count; ++i) {
-      try {
+    try {
+      for (size_t i = 0; i < count; ++i) {
         push_back(value);
-      } catch (...) {
-        clear();
-        throw;
       }
+    } catch (...) {
+      clear();
+      release_spares();
+      throw;
     }
-  } catch (...) {
-    throw;
   }
 
-  List(const List& copy) try
+  constexpr List(const List& copy)
       : node_alloc_(
             std::allocator_traits<Allocator>::
                 select_on_container_copy_construction(copy.node_alloc_)) {
-    for (auto iter = copy.cbegin(); iter != copy.cend(); ++iter) {
-      try {
-        push_back(*iter);
-      } catch (...) {
-        clear();
-        throw;
-      }
+    try {
+      append_copies(copy);
+    } catch (...) {
+      release_spares();
+      throw;
+    }
+  }
+
+  // takes the nodes over; other is left empty
+  constexpr List(List&& other) noexcept
+      : node_alloc_(std::move(other.node_alloc_)) {
+    swap_storage(other);
+    retrack_all();
+  }
+
+  // copies from a List with another allocator type
+  template <class OtherAllocator, class OtherTracer>
+  constexpr explicit List(const List<T, OtherAllocator, OtherTracer>& copy,
+                          const Allocator& alloc = Allocator())
+      : node_alloc_(alloc) {
+    try {
+      append_copies(copy);
+    } catch (...) {
+      release_spares();
+      throw;
     }
-  } catch (...) {
-    throw;
   }
 
   // destructor
-  ~List() {
+  constexpr ~List() {
     while (size_ > 0) {
       pop_front();
     }
+    release_spares();
   }
 
   // operators
-  List& operator=(const List& copy) {
+  constexpr List& operator=(const List& copy) {
+    trace(ListEvent::kCopyAssign, copy.size_);
     if (std::allocator_traits<
             Allocator>::propagate_on_container_copy_assignment::value) {
-      List<T, Allocator> temp(copy.node_alloc_);
-      try {
-        for (auto iter = copy.begin(); iter != copy.end(); ++iter) {
-          temp.push_back(*iter);
-        }
-        std::swap(node_alloc_, temp.node_alloc_);
-        std::swap(size_, temp.size_);
-        std::swap(root_, temp.root_);
+      List temp(copy.node_alloc_);
+      temp.append_copies(copy);
+      std::swap(node_alloc_, temp.node_alloc_);
+      swap_storage(temp);
+      retrack_all();
+      temp.retrack_all();
+      return *this;
+    }
+    assign_copies(copy);
+    return *this;
+  }
 
-      } catch (...) {
-        while (temp.size() > 0) {
-          temp.pop_back();
-        }
-        throw;
+  // takes the nodes over when the allocator propagates or compares equal;
+  // otherwise moves the values into nodes of our own. other is left empty
+  constexpr List& operator=(List&& other) noexcept(
+      std::allocator_traits<
+          Allocator>::propagate_on_container_move_assignment::value ||
+      std::allocator_traits<Allocator>::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
+    trace(ListEvent::kMoveAssign, other.size_);
+    constexpr bool kPropagate = std::allocator_traits<
+        Allocator>::propagate_on_container_move_assignment::value;
+    if (node_alloc_ == other.node_alloc_) {
+      // other takes what storage we keep and frees all it can; runs with
+      // nodes still in other lists stay accounted to it
+      clear();
+      if constexpr (kPropagate) {
+        node_alloc_ = other.node_alloc_;
       }
+      swap_storage(other);
+      other.trim_spares();
+      retrack_all();
+      other.retrack_all();
+      return *this;
+    }
+    if constexpr (kPropagate) {
+      clear();
+      release_spares();
+      node_alloc_ = std::move(other.node_alloc_);
+      swap_storage(other);
+      retrack_all();
+      other.retrack_all();
       return *this;
     }
     size_t prev_size = size_;
-    try {
-      for (auto iter = copy.begin(); iter != copy.end(); ++iter) {
-        push_back(*iter);
-      }
-      while (prev_size > 0) {
-        pop_front();
-        --prev_size;
-      }
-    } catch (...) {
-      while (size_ > prev_size) {
-        pop_back();
-      }
-      throw;
-    };
+    if (!other.empty()) {
+      node_pointer source = other.root_.base->next;
+      append_chain(other.size_, [&](size_t) {
+        node_pointer node = construct_node(std::move(source->value()));
+        source = source->next;
+        return node;
+      });
+    }
+    for (; prev_size > 0; --prev_size) {
+      pop_front();
+    }
+    other.clear();
+    return *this;
+  }
+
+  template <class OtherAllocator, class OtherTracer>
+  constexpr List& operator=(const List<T, OtherAllocator, OtherTracer>& copy) {
+    trace(ListEvent::kCopyAssign, copy.size());
+    assign_copies(copy);
     return *this;
   }
 
   // getters
-  node_allocator_type get_allocator() const { return node_alloc_; }
+  constexpr node_allocator_type get_allocator() const { return node_alloc_; }
+
+  constexpr size_t size() const { return size_; }
 
-  size_t size() const { return size_; }
+  constexpr bool empty() const { return size_ == 0; }
 
-  bool empty() const { return size_ == 0; }
+  // moves the pages holding this list's nodes and values to a NUMA node,
+  // with allocators that can place memory (NumaAllocator); the nodes keep
+  // their addresses, so iterators stay valid. Returns the pages moved.
+  size_t migrate_to_node(int numa_node)
+    requires requires(node_allocator_type& alloc,
+                      std::span<const void* const> objects) {
+      alloc.move_to_node(objects, sizeof(Node), 0);
+    }
+  {
+    std::vector<const void*> nodes;
+    std::vector<const void*> values;
+    if (root_.base != nullptr) {
+      nodes.push_back(std::to_address(root_.base));
+      for (node_pointer node = root_.base->next; node != root_.base;
+           node = node->next) {
+        nodes.push_back(std::to_address(node));
+        if constexpr (kValueOutOfLine) {
+          values.push_back(std::to_address(node->slot.ptr));
+        }
+      }
+    }
+    for (node_pointer node = spare_; node != nullptr; node = node->next) {
+      nodes.push_back(std::to_address(node));
+    }
+    size_t moved = node_alloc_.move_to_node(nodes, sizeof(Node), numa_node);
+    if constexpr (kValueOutOfLine) {
+      value_allocator_type value_alloc(node_alloc_);
+      moved += value_alloc.move_to_node(values, sizeof(T), numa_node);
+    }
+    return moved;
+  }
+
+  // bytes this list holds from its allocator: element and spare nodes, the
+  // sentinel, out-of-line values and run records; the allocator's own
+  // overhead is not included. A run counts whole with the list that
+  // allocated it, also when some of its nodes were spliced elsewhere
+  constexpr size_t memory_usage() const {
+    size_t bytes = kValueOutOfLine ? size_ * sizeof(T) : 0;
+    if constexpr (kAllocatesRuns) {
+      for (run_pointer run = runs_; run != nullptr; run = run->next) {
+        bytes += run->count * sizeof(Node) + sizeof(NodeRun);
+      }
+      return bytes;
+    }
+    size_t held = size_ + spare_count_ + (root_.base != nullptr ? 1 : 0);
+    return bytes + held * sizeof(Node);
+  }
 };
+
+// Range sink that collects a views pipeline straight into a List with one
+// append_range, so no intermediate container is built:
+//   auto evens = lst | std::views::filter(is_even) | to_list();
+//   auto wide = lst | std::views::transform(widen) | to_list<List<long>>();
+// The arguments, an allocator for instance, go to the List constructor.
+template <class ListType, class... Args>
+class ToListAdaptor {
+ public:
+  constexpr explicit ToListAdaptor(Args... args) : args_(std::move(args)...) {}
+
+  template <std::ranges::input_range Range>
+  constexpr auto operator()(Range&& range) const {
+    using result_type =
+        std::conditional_t<std::is_void_v<ListType>,
+                           List<std::ranges::range_value_t<Range>>, ListType>;
+    result_type result = std::make_from_tuple<result_type>(args_);
+    result.append_range(std::forward<Range>(range));
+    return result;
+  }
+
+  template <std::ranges::input_range Range>
+  friend constexpr auto operator|(Range&& range, const ToListAdaptor& sink) {
+    return sink(std::forward<Range>(range));
+  }
+
+ private:
+  std::tuple<Args...> args_;
+};
+
+template <class ListType = void, class... Args>
+constexpr ToListAdaptor<ListType, std::decay_t<Args>...> to_list(
+    Args&&... args) {
+  return ToListAdaptor<ListType, std::decay_t<Args>...>(
+      std::forward<Args>(args)...);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+
+// Bookkeeping behind LIST_CHECKED_ITERATORS: every live node and sentinel
+// of every List, with the list that owns it and a generation that is never
+// reused, so an iterator to an erased node fails the check even when the
+// address has been handed out again.
+class ListIteratorRegistry {
+ public:
+  static uint64_t add(const void* node, const void* owner, bool sentinel) {
+    Registry& registry = instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    uint64_t generation = ++registry.last_generation;
+    registry.nodes[node] = Entry{owner, generation, sentinel};
+    return generation;
+  }
+
+  static void remove(const void* node) {
+    Registry& registry = instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    registry.nodes.erase(node);
+  }
+
+  static void set_owner(const void* node, const void* owner) {
+    Registry& registry = instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    auto found = registry.nodes.find(node);
+    if (found != registry.nodes.end()) {
+      found->second.owner = owner;
+    }
+  }
+
+  // 0 for a node that is not live
+  static uint64_t generation_of(const void* node) {
+    Registry& registry = instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    auto found = registry.nodes.find(node);
+    return found == registry.nodes.end() ? 0 : found->second.generation;
+  }
+
+  // aborts with a message unless node is live with the given generation,
+  // owned by owner (when not null) and, if a value is needed, not a sentinel.
+  // Generation 0 marks a node that was not registered when the iterator
+  // reached it: a list whose bytes were mapped in from elsewhere, such as a
+  // shared memory segment attached at another address. Those pass unchecked.
+  static void check(const void* node, uint64_t generation, const void* owner,
+                    bool need_value, const char* operation) {
+    if (node == nullptr) {
+      fail(operation, "singular iterator or end() of an empty list");
+    }
+    if (generation == 0) {
+      return;
+    }
+    Registry& registry = instance();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    auto found = registry.nodes.find(node);
+    if (found == registry.nodes.end() ||
+        found->second.generation != generation) {
+      fail(operation, "iterator to an erased element");
+    }
+    if (owner != nullptr && found->second.owner != owner) {
+      fail(operation, "iterator belongs to another list");
+    }
+    if (need_value && found->second.sentinel) {
+      fail(operation, "end() is not dereferenceable");
+    }
+  }
+
+ private:
+  struct Entry {
+    const void* owner;
+    uint64_t generation;
+    bool sentinel;
+  };
+
+  struct Registry {
+    std::mutex mutex;
+    std::unordered_map<const void*, Entry> nodes;
+    uint64_t last_generation = 0;
+  };
+
+  static Registry& instance() {
+    static Registry registry;
+    return registry;
+  }
+
+  [[noreturn]] static void fail(const char* operation, const char* reason) {
+    std::cerr << "List: " << operation << ": " << reason << std::endl;
+    std::abort();
+  }
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Events List reports to its Tracer.
+enum class ListEvent : uint8_t {
+  kConstructNode,
+  kErase,
+  kAllocateBaseNode,
+  kCopyAssign,
+  kMoveAssign,
+};
+
+inline const char* ListEventName(ListEvent event) {
+  switch (event) {
+    case ListEvent::kConstructNode:
+      return "construct_node";
+    case ListEvent::kErase:
+      return "erase";
+    case ListEvent::kAllocateBaseNode:
+      return "allocate_base_node";
+    case ListEvent::kCopyAssign:
+      return "copy_assign";
+    case ListEvent::kMoveAssign:
+      return "move_assign";
+  }
+  return "unknown";
+}
+
+// Default tracer. record is an empty constexpr function, so the calls
+// inline away.
+struct NullListTracer {
+  static constexpr void record(ListEvent, const void*, size_t) noexcept {}
+};
+
+struct ListTraceRecord {
+  uint64_t timestamp_ns;
+  const void* list;
+  uint32_t count;
+  uint32_t thread;
+  ListEvent event;
+};
+
+// Tracer that appends to a fixed per-thread ring, so recording takes no lock
+// and never allocates after a thread's first event. Old records are
+// overwritten. Dumping while other threads record may catch a record being
+// rewritten; dump at a quiet point when exact output matters.
+class RingBufferListTracer {
+ public:
+  static constexpr size_t kRingCapacity = 1 << 14;
+
+  // List calls this from operations that must not fail because of tracing,
+  // so an event whose thread has no ring and cannot get one is dropped
+  static void record(ListEvent event, const void* list, size_t count) noexcept {
+    Ring* ring = nullptr;
+    try {
+      ring = &local_ring();
+    } catch (...) {
+      return;
+    }
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->records[head % kRingCapacity] = ListTraceRecord{
+        now_ns(), list, static_cast<uint32_t>(count), ring->thread, event};
+    ring->head.store(head + 1, std::memory_order_release);
+  }
+
+  // creates the calling thread's ring now, so a thread that must not lose
+  // events learns of a failed allocation as std::bad_alloc up front
+  static void register_thread() { local_ring(); }
+
+  // records of every thread that has traced, oldest first within a thread
+  static std::vector<ListTraceRecord> snapshot() {
+    std::vector<ListTraceRecord> result;
+    std::lock_guard<std::mutex> guard(registry().mutex);
+    for (const auto& ring : registry().rings) {
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      uint64_t begin = head > kRingCapacity ? head - kRingCapacity : 0;
+      for (uint64_t i = begin; i < head; ++i) {
+        result.push_back(ring->records[i % kRingCapacity]);
+      }
+    }
+    return result;
+  }
+
+  // Chrome trace event format, loadable in chrome://tracing or Perfetto
+  static void dump_chrome_trace(std::ostream& out) {
+    out << "{\"traceEvents\":[";
+    bool first = true;
+    for (const ListTraceRecord& record : snapshot()) {
+      out << (first ? "" : ",") << "\n{\"name\":\""
+          << ListEventName(record.event)
+          << "\",\"cat\":\"list\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1"
+          << ",\"tid\":" << record.thread
+          << ",\"ts\":" << record.timestamp_ns / 1000 << "."
+          << record.timestamp_ns % 1000 / 100 << ",\"args\":{\"list\":\""
+          << record.list << "\",\"count\":" << record.count << "}}";
+      first = false;
+    }
+    out << "\n]}\n";
+  }
+
+  // drops recorded events; only safe while no thread is recording
+  static void reset() {
+    std::lock_guard<std::mutex> guard(registry().mutex);
+    for (const auto& ring : registry().rings) {
+      ring->head.store(0, std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  struct Ring {
+    std::atomic<uint64_t> head{0};
+    uint32_t thread = 0;
+    std::array<ListTraceRecord, kRingCapacity> records;
+  };
+
+  struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Ring>> rings;
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+  };
+
+  static Registry& registry() {
+    static Registry instance;
+    return instance;
+  }
+
+  // the registry keeps rings of finished threads alive for later dumps; a
+  // failed creation leaves the thread without a ring and is retried later
+  static Ring& local_ring() {
+    thread_local std::shared_ptr<Ring> ring;
+    if (ring == nullptr) {
+      auto created = std::make_shared<Ring>();
+      std::lock_guard<std::mutex> guard(registry().mutex);
+      created->thread = static_cast<uint32_t>(registry().rings.size());
+      registry().rings.push_back(created);
+      ring = std::move(created);
+    }
+    return *ring;
+  }
+
+  static uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - registry().start)
+        .count();
+  }
+};
+
+// tracer used by List unless one is passed explicitly
+#ifdef LIST_ENABLE_TRACING
+using ListDefaultTracer = RingBufferListTracer;
+#else
+using ListDefaultTracer = NullListTracer;
+#endif
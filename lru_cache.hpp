@@ -0,0 +1,277 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "list.hpp"
+#include "pool_allocator.hpp"
+
+// Fixed-capacity LRU cache. Entries live in a List ordered from least to
+// most recently used; a hit moves its node to the back by relinking, and a
+// miss on a full cache reuses the least recently used node in place, so the
+// steady state performs no allocations. List nodes and hash nodes come from
+// one shared NodePool, and buckets are sized once for the capacity.
+template <class K, class V,
+          class Allocator = std::allocator<std::pair<const K, V>>,
+          class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+class LruCache {
+ private:
+  using entry_type = std::pair<K, V>;
+  using entry_allocator_type = PoolAllocator<
+      entry_type,
+      typename std::allocator_traits<Allocator>::template rebind_alloc<
+          entry_type>>;
+  using list_type = List<entry_type, entry_allocator_type>;
+  using list_iterator = typename list_type::iterator;
+
+  // the index refers to the key stored in the list node
+  struct KeyRef {
+    const K* key;
+  };
+
+  struct RefHash {
+    Hash hash;
+
+    size_t operator()(const KeyRef& ref) const { return hash(*ref.key); }
+  };
+
+  struct RefEqual {
+    KeyEqual equal;
+
+    bool operator()(const KeyRef& lhs, const KeyRef& rhs) const {
+      return equal(*lhs.key, *rhs.key);
+    }
+  };
+
+  using index_allocator_type =
+      typename std::allocator_traits<entry_allocator_type>::
+          template rebind_alloc<std::pair<const KeyRef, list_iterator>>;
+  using index_type = std::unordered_map<KeyRef, list_iterator, RefHash,
+                                        RefEqual, index_allocator_type>;
+
+  // output iterator that drops what it is given
+  struct Discard {
+    Discard& operator*() { return *this; }
+    Discard& operator++() { return *this; }
+    Discard& operator=(entry_type&&) { return *this; }
+  };
+
+  size_t capacity_;
+  list_type entries_;
+  index_type index_;
+
+  list_iterator lookup(const K& key) {
+    auto found = index_.find(KeyRef{&key});
+    return found == index_.end() ? entries_.end() : found->second;
+  }
+
+  void promote(list_iterator iter) {
+    entries_.splice(entries_.end(), entries_, iter);
+  }
+
+ public:
+  // usings
+  using key_type = K;
+  using mapped_type = V;
+  using allocator_type = Allocator;
+
+  explicit LruCache(size_t capacity, const Allocator& alloc = Allocator())
+      : capacity_(capacity),
+        entries_(entry_allocator_type(alloc)),
+        index_(capacity, RefHash(), RefEqual(),
+               index_allocator_type(entries_.get_allocator())) {}
+
+  LruCache(const LruCache&) = delete;
+  LruCache& operator=(const LruCache&) = delete;
+
+  // returns the cached value and marks it most recently used, or nullptr
+  V* get(const K& key) {
+    if (index_.empty()) {
+      return nullptr;
+    }
+    list_iterator iter = lookup(key);
+    if (iter == entries_.end()) {
+      return nullptr;
+    }
+    promote(iter);
+    return &iter->second;
+  }
+
+  bool contains(const K& key) const {
+    return index_.find(KeyRef{&key}) != index_.end();
+  }
+
+  // inserts or overwrites key and marks it most recently used
+  void put(const K& key, V value) {
+    if (capacity_ == 0) {
+      return;
+    }
+    if (!index_.empty()) {
+      list_iterator iter = lookup(key);
+      if (iter != entries_.end()) {
+        iter->second = std::move(value);
+        promote(iter);
+        return;
+      }
+    }
+    if (entries_.size() < capacity_) {
+      entries_.push_back(entry_type(key, std::move(value)));
+      list_iterator iter = --entries_.end();
+      try {
+        index_.emplace(KeyRef{&iter->first}, iter);
+      } catch (...) {
+        entries_.pop_back();
+        throw;
+      }
+      return;
+    }
+    // full: recycle the least recently used node for the new entry. If the
+    // new entry cannot be stored, the victim is dropped as if evicted, so
+    // no list entry is ever left without an index entry
+    list_iterator victim = entries_.begin();
+    index_.erase(KeyRef{&victim->first});
+    try {
+      victim->first = key;
+      victim->second = std::move(value);
+      index_.emplace(KeyRef{&victim->first}, victim);
+    } catch (...) {
+      entries_.erase(victim);
+      throw;
+    }
+    promote(victim);
+  }
+
+  bool erase(const K& key) {
+    if (index_.empty()) {
+      return false;
+    }
+    auto found = index_.find(KeyRef{&key});
+    if (found == index_.end()) {
+      return false;
+    }
+    list_iterator iter = found->second;
+    index_.erase(found);
+    entries_.erase(iter);
+    return true;
+  }
+
+  // moves up to count least recently used entries into out, then unlinks
+  // them in one run. An index entry goes right before its element is moved
+  // out, while the key in the node can still be hashed; if out throws, the
+  // entries written so far and the one being written are unlinked as
+  // evicted, so no entry is left in the list without an index entry
+  template <class OutputIt>
+  OutputIt evict(size_t count, OutputIt out) {
+    count = std::min(count, entries_.size());
+    size_t unindexed = 0;
+    try {
+      for (list_iterator iter = entries_.begin(); unindexed < count; ++iter) {
+        index_.erase(KeyRef{&iter->first});
+        ++unindexed;
+        *out = std::move(*iter);
+        ++out;
+      }
+    } catch (...) {
+      entries_.pop_front_n(unindexed, Discard());
+      throw;
+    }
+    entries_.pop_front_n(count, Discard());
+    return out;
+  }
+
+  size_t evict(size_t count) {
+    count = std::min(count, entries_.size());
+    evict(count, Discard());
+    return count;
+  }
+
+  // shrinking evicts the surplus in one batch
+  void set_capacity(size_t capacity) {
+    capacity_ = capacity;
+    if (entries_.size() > capacity_) {
+      evict(entries_.size() - capacity_);
+    }
+  }
+
+  // getters
+  size_t size() const { return entries_.size(); }
+
+  size_t capacity() const { return capacity_; }
+
+  bool empty() const { return entries_.empty(); }
+};
+
+// LruCache split into Shards independently locked caches picked by key
+// hash. Values are returned by copy because a pointer would outlive the
+// shard lock.
+template <class K, class V, size_t Shards = 16,
+          class Allocator = std::allocator<std::pair<const K, V>>,
+          class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>>
+class ShardedLruCache {
+ private:
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    LruCache<K, V, Allocator, Hash, KeyEqual> cache;
+
+    Shard(size_t capacity, const Allocator& alloc) : cache(capacity, alloc) {}
+  };
+
+  Hash hash_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  Shard& shard_for(const K& key) {
+    // the low bits of std::hash are often the identity, so mix them
+    size_t hash = hash_(key) * 0x9e3779b97f4a7c15ULL;
+    return *shards_[static_cast<size_t>(hash >> 32) % Shards];
+  }
+
+ public:
+  explicit ShardedLruCache(size_t capacity,
+                           const Allocator& alloc = Allocator()) {
+    shards_.reserve(Shards);
+    for (size_t i = 0; i < Shards; ++i) {
+      shards_.push_back(
+          std::make_unique<Shard>((capacity + Shards - 1) / Shards, alloc));
+    }
+  }
+
+  ShardedLruCache(const ShardedLruCache&) = delete;
+  ShardedLruCache& operator=(const ShardedLruCache&) = delete;
+
+  std::optional<V> get(const K& key) {
+    Shard& target = shard_for(key);
+    std::lock_guard<std::mutex> guard(target.mutex);
+    if (V* value = target.cache.get(key)) {
+      return *value;
+    }
+    return std::nullopt;
+  }
+
+  void put(const K& key, V value) {
+    Shard& target = shard_for(key);
+    std::lock_guard<std::mutex> guard(target.mutex);
+    target.cache.put(key, std::move(value));
+  }
+
+  bool erase(const K& key) {
+    Shard& target = shard_for(key);
+    std::lock_guard<std::mutex> guard(target.mutex);
+    return target.cache.erase(key);
+  }
+
+  size_t size() {
+    size_t total = 0;
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> guard(shard->mutex);
+      total += shard->cache.size();
+    }
+    return total;
+  }
+};
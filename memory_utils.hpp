@@ -1,6 +1,8 @@
 #pragma once
+#include <bit>
 #include <cstdio>
 #include <tuple>
+#include <type_traits>
 #include <memory>
 #include <cstdlib>
 
@@ -12,6 +14,7 @@ struct MemoryManager {
 
   static size_t allocator_constructed;
   static size_t allocator_destroyed;
+  static size_t allocator_calls;
 
   static void TypeNewAllocate(size_t n) {
     type_new_allocated += n;
@@ -23,6 +26,7 @@ struct MemoryManager {
 
   static void AllocatorAllocate(size_t n) {
     allocator_allocated += n;
+    allocator_calls += 1;
   }
 
   static void AllocatorDeallocate(size_t n) {
@@ -100,6 +104,46 @@ bool operator==(const AllocatorWithCount<T>& lhs, const AllocatorWithCount<T>& r
       lhs.allocator_destroyed == rhs.allocator_destroyed;
 }
 
+// Stand-in for a size-class allocator such as jemalloc: a request is served
+// from the smallest class that fits it, and allocate_at_least reports how
+// many objects that class really holds. node_runs asks List to take its
+// nodes in runs.
+template <typename T>
+struct SizeClassAllocatorWithCount : AllocatorWithCount<T> {
+  using node_runs = std::true_type;
+
+  struct AllocationResult {
+    T* ptr;
+    size_t count;
+  };
+
+  template <typename U>
+  struct rebind {
+    using other = SizeClassAllocatorWithCount<U>;
+  };
+
+  SizeClassAllocatorWithCount() = default;
+
+  template <typename U>
+  SizeClassAllocatorWithCount(const SizeClassAllocatorWithCount<U>& other) {
+    std::ignore = other;
+  }
+
+  // 16-byte steps up to 128, then four classes per doubling
+  static size_t SizeClass(size_t bytes) {
+    if (bytes <= 128) {
+      return (bytes + 15) / 16 * 16;
+    }
+    size_t step = std::bit_floor(bytes - 1) / 4;
+    return (bytes + step - 1) / step * step;
+  }
+
+  AllocationResult allocate_at_least(size_t n) {
+    size_t count = SizeClass(n * sizeof(T)) / sizeof(T);
+    return {AllocatorWithCount<T>::allocate(count), count};
+  }
+};
+
 template <typename T, bool PropagateOnConstruct, bool PropagateOnAssign>
 struct WhimsicalAllocator : public std::allocator<T> {
   std::shared_ptr<int> number;
@@ -0,0 +1,256 @@
+#pragma once
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "slab_arena.hpp"
+
+// NUMA placement through the raw syscalls, so no libnuma is needed. Every
+// call degrades to a no-op on kernels or machines without NUMA support:
+// memory is then placed wherever the kernel chooses.
+class Numa {
+ public:
+  static constexpr int kMaxNodes = 1024;
+
+  // highest online node + 1; 1 when the topology is unknown
+  static int node_count() {
+    std::vector<int> nodes = parse_list("/sys/devices/system/node/online");
+    if (nodes.empty()) {
+      return 1;
+    }
+    return *std::max_element(nodes.begin(), nodes.end()) + 1;
+  }
+
+  // node of the CPU the calling thread runs on, 0 when unknown
+  static int current_node() {
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+      return 0;
+    }
+    return static_cast<int>(node);
+  }
+
+  // node holding the page of ptr, -1 when the page is not resident or the
+  // kernel cannot tell
+  static int node_of(const void* ptr) {
+    const void* page = page_of(ptr);
+    int status = -1;
+    if (syscall(SYS_move_pages, 0, 1UL, &page, nullptr, &status, 0) != 0) {
+      return -1;
+    }
+    return status >= 0 ? status : -1;
+  }
+
+  static std::vector<int> cpus_of(int node) {
+    return parse_list("/sys/devices/system/node/node" + std::to_string(node) +
+                      "/cpulist");
+  }
+
+  static size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+  }
+
+  static const void* page_of(const void* ptr) {
+    return reinterpret_cast<const void*>(reinterpret_cast<uintptr_t>(ptr) &
+                                         ~(page_size() - 1));
+  }
+
+  // sets the preferred node of the page-aligned range [addr, addr + bytes)
+  // for pages faulted from now on; with move, resident pages follow
+  static bool bind(void* addr, size_t bytes, int node, bool move) {
+    if (node < 0 || node >= kMaxNodes) {
+      return false;
+    }
+    NodeMask mask = {};
+    mask.bits[node / kMaskBits] = 1UL << (node % kMaskBits);
+    unsigned flags = move ? kMoveFlag : 0;
+    return syscall(SYS_mbind, addr, bytes, kPreferred, mask.bits,
+                   static_cast<unsigned long>(kMaxNodes), flags) == 0;
+  }
+
+  // moves resident pages to node; returns how many of them are there now
+  static size_t move_pages(std::span<const void* const> pages, int node) {
+    if (pages.empty()) {
+      return 0;
+    }
+    std::vector<int> nodes(pages.size(), node);
+    std::vector<int> status(pages.size(), -1);
+    if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nodes.data(),
+                status.data(), kMoveFlag) < 0) {
+      return 0;
+    }
+    return static_cast<size_t>(std::count(status.begin(), status.end(), node));
+  }
+
+ private:
+  static constexpr int kMaskBits = 8 * sizeof(unsigned long);
+  // from <linux/mempolicy.h>
+  static constexpr int kPreferred = 1;
+  static constexpr unsigned kMoveFlag = 1 << 1;
+
+  struct NodeMask {
+    unsigned long bits[kMaxNodes / kMaskBits];
+  };
+
+  // "0-3,8,10-11" as in sysfs
+  static std::vector<int> parse_list(const std::string& path) {
+    std::ifstream in(path);
+    std::string text;
+    std::vector<int> result;
+    if (!(in >> text)) {
+      return result;
+    }
+    size_t pos = 0;
+    while (pos < text.size()) {
+      size_t end = text.find(',', pos);
+      if (end == std::string::npos) {
+        end = text.size();
+      }
+      std::string range = text.substr(pos, end - pos);
+      size_t dash = range.find('-');
+      int first = std::stoi(range.substr(0, dash));
+      int last =
+          dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int value = first; value <= last; ++value) {
+        result.push_back(value);
+      }
+      pos = end + 1;
+    }
+    return result;
+  }
+};
+
+// Slab arena bound to one NUMA node: the kernel places the pages of every
+// slab and large block on that node. Meant for lists owned by a thread
+// pinned to the node.
+class NumaArena : public SlabArena<NumaArena> {
+ public:
+  static constexpr size_t kSlabSize = 1 << 20;
+
+  explicit NumaArena(int node = Numa::current_node())
+      : SlabArena(kSlabSize), node_(node) {}
+
+  // moves the given pages to node. Every slab is rebound to node, so pages
+  // faulted from now on, in new slabs or the untouched rest of old ones,
+  // land there; the pages holding freed blocks move too, since allocations
+  // reuse those first. Such a page may also hold live blocks of other
+  // users of the arena, which move along. Returns the pages moved
+  size_t move_to_node(std::span<const void* const> pages, int node) {
+    node_ = node;
+    for (void* slab : slabs()) {
+      Numa::bind(slab, slab_size(), node_, false);
+    }
+    std::vector<const void*> moving(pages.begin(), pages.end());
+    for_each_free_block(
+        [&](void* block) { moving.push_back(Numa::page_of(block)); });
+    std::sort(moving.begin(), moving.end());
+    moving.erase(std::unique(moving.begin(), moving.end()), moving.end());
+    return Numa::move_pages(moving, node);
+  }
+
+  // getters
+  int node() const { return node_; }
+
+ private:
+  friend class SlabArena<NumaArena>;
+
+  int node_;
+
+  void* map_slab(size_t bytes) { return map(bytes); }
+
+  void* map_block(size_t bytes) { return map(bytes); }
+
+  // the policy is set before the first touch, so no page has to move
+  void* map(size_t bytes) {
+    void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    Numa::bind(ptr, bytes, node_, false);
+    return ptr;
+  }
+};
+
+// Allocator over a NumaArena shared by its copies and rebinds. List detects
+// move_to_node and offers List::migrate_to_node with it.
+template <class T>
+class NumaAllocator {
+ private:
+  template <class U>
+  friend class NumaAllocator;
+
+  std::shared_ptr<NumaArena> arena_;
+
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  // constructors; the default places memory on the calling thread's node
+  explicit NumaAllocator(int node = Numa::current_node())
+      : arena_(std::make_shared<NumaArena>(node)) {}
+
+  explicit NumaAllocator(std::shared_ptr<NumaArena> arena)
+      : arena_(std::move(arena)) {}
+
+  template <class U>
+  NumaAllocator(const NumaAllocator<U>& other) : arena_(other.arena_) {}
+
+  // methods
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    arena_->deallocate(ptr, n * sizeof(T), alignof(T));
+  }
+
+  // moves the pages holding the given objects of object_size bytes each to
+  // node, along with the arena's freed blocks; later allocations, recycled
+  // blocks included, go there as well. Returns the pages moved
+  size_t move_to_node(std::span<const void* const> objects, size_t object_size,
+                      int node) {
+    std::vector<const void*> pages;
+    for (const void* object : objects) {
+      const char* first = static_cast<const char*>(object);
+      for (const char* page = static_cast<const char*>(Numa::page_of(first));
+           page < first + object_size; page += Numa::page_size()) {
+        pages.push_back(page);
+      }
+    }
+    std::sort(pages.begin(), pages.end());
+    pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+    return arena_->move_to_node(pages, node);
+  }
+
+  // getters
+  int node() const { return arena_->node(); }
+
+  const std::shared_ptr<NumaArena>& arena() const { return arena_; }
+
+  template <class U>
+  bool operator==(const NumaAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+
+  template <class U>
+  bool operator!=(const NumaAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+};
@@ -0,0 +1,151 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Unit the pool carves blocks from; a block of class i spans i + 1 granules.
+struct alignas(std::max_align_t) PoolGranule {
+  unsigned char bytes[alignof(std::max_align_t)];
+};
+
+// Free lists of single-object blocks, one per size class, shared by every
+// copy and rebind of one PoolAllocator. Blocks return to the upstream
+// allocator only when the pool is destroyed. Not thread-safe.
+template <class GranuleAllocator>
+class NodePool {
+ private:
+  static constexpr size_t kClassCount = 32;
+
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  using granule_traits = std::allocator_traits<GranuleAllocator>;
+
+  GranuleAllocator upstream_;
+  FreeBlock* free_[kClassCount] = {};
+
+  static size_t class_of(size_t size) {
+    return (size - 1) / sizeof(PoolGranule);
+  }
+
+ public:
+  static constexpr size_t max_pooled_size = sizeof(PoolGranule) * kClassCount;
+
+  explicit NodePool(const GranuleAllocator& upstream) : upstream_(upstream) {}
+
+  NodePool(const NodePool&) = delete;
+  NodePool& operator=(const NodePool&) = delete;
+
+  ~NodePool() {
+    for (size_t index = 0; index < kClassCount; ++index) {
+      while (free_[index] != nullptr) {
+        FreeBlock* block = free_[index];
+        free_[index] = block->next;
+        granule_traits::deallocate(
+            upstream_, reinterpret_cast<PoolGranule*>(block), index + 1);
+      }
+    }
+  }
+
+  // size must be in (0, max_pooled_size]
+  void* allocate(size_t size) {
+    size_t index = class_of(size);
+    if (free_[index] != nullptr) {
+      FreeBlock* block = free_[index];
+      free_[index] = block->next;
+      return block;
+    }
+    return std::to_address(granule_traits::allocate(upstream_, index + 1));
+  }
+
+  void deallocate(void* ptr, size_t size) noexcept {
+    size_t index = class_of(size);
+    free_[index] = ::new (ptr) FreeBlock{free_[index]};
+  }
+};
+
+// Allocator that recycles single-object allocations through a shared
+// NodePool instead of returning them to Upstream. Arrays (hash buckets,
+// for instance) and objects larger than a pooled block go to Upstream.
+template <class T, class Upstream = std::allocator<T>>
+class PoolAllocator {
+ private:
+  template <class U, class OtherUpstream>
+  friend class PoolAllocator;
+
+  using upstream_type =
+      typename std::allocator_traits<Upstream>::template rebind_alloc<T>;
+  using upstream_traits = std::allocator_traits<upstream_type>;
+  using pool_type = NodePool<typename std::allocator_traits<
+      Upstream>::template rebind_alloc<PoolGranule>>;
+
+  std::shared_ptr<pool_type> pool_;
+  upstream_type upstream_;
+
+  static constexpr bool kPooled = sizeof(T) <= pool_type::max_pooled_size &&
+                                  alignof(T) <= alignof(PoolGranule);
+
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+  using is_always_equal = std::false_type;
+
+  template <class U>
+  struct rebind {
+    using other = PoolAllocator<
+        U, typename std::allocator_traits<Upstream>::template rebind_alloc<U>>;
+  };
+
+  // constructors
+  explicit PoolAllocator(const Upstream& upstream = Upstream())
+      : pool_(std::make_shared<pool_type>(upstream)), upstream_(upstream) {}
+
+  template <class U, class OtherUpstream>
+  PoolAllocator(const PoolAllocator<U, OtherUpstream>& other)
+      : pool_(other.pool_), upstream_(other.upstream_) {}
+
+  // methods
+  T* allocate(size_t n) {
+    if constexpr (kPooled) {
+      if (n == 1) {
+        return static_cast<T*>(pool_->allocate(sizeof(T)));
+      }
+    }
+    return std::to_address(upstream_traits::allocate(upstream_, n));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if constexpr (kPooled) {
+      if (n == 1) {
+        pool_->deallocate(ptr, sizeof(T));
+        return;
+      }
+    }
+    upstream_traits::deallocate(upstream_, ptr, n);
+  }
+
+  template <class U, class... Args>
+  void construct(U* ptr, Args&&... args) {
+    upstream_traits::construct(upstream_, ptr, std::forward<Args>(args)...);
+  }
+
+  template <class U>
+  void destroy(U* ptr) {
+    upstream_traits::destroy(upstream_, ptr);
+  }
+
+  template <class U, class OtherUpstream>
+  bool operator==(const PoolAllocator<U, OtherUpstream>& other) const {
+    return pool_ == other.pool_;
+  }
+
+  template <class U, class OtherUpstream>
+  bool operator!=(const PoolAllocator<U, OtherUpstream>& other) const {
+    return pool_ != other.pool_;
+  }
+};
@@ -0,0 +1,370 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Epoch bookkeeping shared by the readers and the writer of one RcuList.
+// A reader publishes the epoch it started in; a node retired at epoch E is
+// freed once no reader that started before E is still running.
+class EpochDomain {
+ public:
+  static constexpr size_t kReaderSlots = 128;
+
+  EpochDomain() = default;
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  size_t enter() noexcept {
+    size_t start = std::hash<std::thread::id>()(std::this_thread::get_id());
+    for (;;) {
+      for (size_t i = 0; i < kReaderSlots; ++i) {
+        size_t index = (start + i) % kReaderSlots;
+        uint64_t expected = 0;
+        // acquire: a reader that sees epoch E also sees every unlink that
+        // was retired at E
+        uint64_t epoch = epoch_.load(std::memory_order_acquire);
+        if (slots_[index].epoch.compare_exchange_strong(
+                expected, epoch, std::memory_order_relaxed)) {
+          // pairs with the fence in retire(): either the writer sees this
+          // slot or this reader sees the unlink that preceded the retire
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          return index;
+        }
+      }
+      std::this_thread::yield();
+    }
+  }
+
+  void leave(size_t slot) noexcept {
+    slots_[slot].epoch.store(0, std::memory_order_release);
+  }
+
+  // called by the writer after unlinking; returns the epoch to stamp
+  uint64_t retire() noexcept {
+    uint64_t epoch = epoch_.fetch_add(1, std::memory_order_acq_rel) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return epoch;
+  }
+
+  // smallest epoch a running reader started in, UINT64_MAX when idle
+  uint64_t oldest_reader() const noexcept {
+    uint64_t oldest = UINT64_MAX;
+    for (const auto& slot : slots_) {
+      uint64_t epoch = slot.epoch.load(std::memory_order_acquire);
+      if (epoch != 0 && epoch < oldest) {
+        oldest = epoch;
+      }
+    }
+    return oldest;
+  }
+
+ private:
+  struct alignas(64) ReaderSlot {
+    std::atomic<uint64_t> epoch{0};
+  };
+
+  std::atomic<uint64_t> epoch_{1};
+  ReaderSlot slots_[kReaderSlots];
+};
+
+// Doubly linked list with lock-free readers and one writer at a time.
+// Readers walk forward links only, inside a ReadGuard; the writer keeps the
+// back links for itself. Erased nodes are destroyed through the allocator
+// after every reader that could still hold them has left.
+template <class T, class Allocator = std::allocator<T>>
+class RcuList {
+ private:
+  // base structures
+  class BaseNode {
+   public:
+    std::atomic<BaseNode*> next{nullptr};
+    BaseNode* prev = nullptr;
+  };
+
+  class Node : public BaseNode {
+   public:
+    Node* retired_next = nullptr;
+    uint64_t retire_epoch = 0;
+    T value;
+
+    template <class... Args>
+    explicit Node(std::in_place_t, Args&&... args)
+        : value(std::forward<Args>(args)...) {}
+  };
+
+ public:
+  // usings
+  using value_type = T;
+  using allocator_type = Allocator;
+  using node_allocator_type =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+  using node_allocator_traits =
+      typename std::allocator_traits<node_allocator_type>;
+
+ private:
+  static constexpr size_t kReclaimThreshold = 64;
+
+  node_allocator_type node_alloc_;
+  std::mutex writer_mutex_;
+  mutable EpochDomain domain_;
+  // sentinel lives in the object, so the list never allocates it
+  BaseNode root_;
+  std::atomic<size_t> size_{0};
+  Node* retired_head_ = nullptr;
+  Node* retired_tail_ = nullptr;
+  size_t retired_count_ = 0;
+
+  BaseNode* sentinel() const { return const_cast<BaseNode*>(&root_); }
+
+  template <class... Args>
+  Node* construct_node(Args&&... args) {
+    auto node = node_allocator_traits::allocate(node_alloc_, 1);
+    try {
+      node_allocator_traits::construct(node_alloc_, std::to_address(node),
+                                       std::in_place,
+                                       std::forward<Args>(args)...);
+    } catch (...) {
+      node_allocator_traits::deallocate(node_alloc_, node, 1);
+      throw;
+    }
+    return std::to_address(node);
+  }
+
+  void destroy_node(Node* node) {
+    node_allocator_traits::destroy(node_alloc_, node);
+    node_allocator_traits::deallocate(
+        node_alloc_,
+        std::pointer_traits<typename node_allocator_traits::pointer>::
+            pointer_to(*node),
+        1);
+  }
+
+  // writer side; the node becomes visible to readers with the release store
+  template <class... Args>
+  BaseNode* emplace_before(BaseNode* pos, Args&&... args) {
+    Node* node = construct_node(std::forward<Args>(args)...);
+    BaseNode* prev = pos->prev;
+    node->next.store(pos, std::memory_order_relaxed);
+    node->prev = prev;
+    pos->prev = node;
+    prev->next.store(node, std::memory_order_release);
+    size_.fetch_add(1, std::memory_order_relaxed);
+    return node;
+  }
+
+  // an unlinked node keeps its forward link, so a reader standing on it
+  // still reaches the rest of the list
+  void unlink(BaseNode* base) {
+    Node* node = static_cast<Node*>(base);
+    BaseNode* next = node->next.load(std::memory_order_relaxed);
+    node->prev->next.store(next, std::memory_order_release);
+    next->prev = node->prev;
+    size_.fetch_sub(1, std::memory_order_relaxed);
+
+    node->retire_epoch = domain_.retire();
+    node->retired_next = nullptr;
+    if (retired_tail_ == nullptr) {
+      retired_head_ = node;
+    } else {
+      retired_tail_->retired_next = node;
+    }
+    retired_tail_ = node;
+    if (++retired_count_ >= kReclaimThreshold) {
+      reclaim();
+    }
+  }
+
+  // retired nodes are queued in epoch order, so freeing stops at the first
+  // one a reader may still see
+  size_t reclaim() {
+    uint64_t oldest = domain_.oldest_reader();
+    size_t freed = 0;
+    while (retired_head_ != nullptr && retired_head_->retire_epoch <= oldest) {
+      Node* node = retired_head_;
+      retired_head_ = node->retired_next;
+      destroy_node(node);
+      ++freed;
+    }
+    if (retired_head_ == nullptr) {
+      retired_tail_ = nullptr;
+    }
+    retired_count_ -= freed;
+    return freed;
+  }
+
+ public:
+  // valid only inside the ReadGuard, or writer call, it was obtained in
+  class const_iterator {
+   private:
+    BaseNode* itptr_ = nullptr;
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+
+    explicit const_iterator(BaseNode* ptr) : itptr_(ptr) {}
+
+    reference operator*() const { return static_cast<Node*>(itptr_)->value; }
+
+    pointer operator->() const { return &static_cast<Node*>(itptr_)->value; }
+
+    const_iterator& operator++() {
+      itptr_ = itptr_->next.load(std::memory_order_acquire);
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      const_iterator temp(*this);
+      ++(*this);
+      return temp;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return itptr_ == other.itptr_;
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return itptr_ != other.itptr_;
+    }
+
+    BaseNode* get_ptr() const { return itptr_; }
+  };
+
+  // read-side critical section; nodes reachable from it are not freed
+  // before it ends
+  class ReadGuard {
+   private:
+    const RcuList* list_;
+    size_t slot_;
+
+   public:
+    explicit ReadGuard(const RcuList& list)
+        : list_(&list), slot_(list.domain_.enter()) {}
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    ~ReadGuard() { list_->domain_.leave(slot_); }
+
+    const_iterator begin() const {
+      return const_iterator(list_->root_.next.load(std::memory_order_acquire));
+    }
+
+    const_iterator end() const { return const_iterator(list_->sentinel()); }
+  };
+
+  // constructors
+  explicit RcuList(const Allocator& alloc = Allocator()) : node_alloc_(alloc) {
+    root_.next.store(&root_, std::memory_order_relaxed);
+    root_.prev = &root_;
+  }
+
+  RcuList(const RcuList&) = delete;
+  RcuList& operator=(const RcuList&) = delete;
+
+  // destructor; no reader may be active
+  ~RcuList() {
+    BaseNode* node = root_.next.load(std::memory_order_relaxed);
+    while (node != &root_) {
+      BaseNode* next = node->next.load(std::memory_order_relaxed);
+      destroy_node(static_cast<Node*>(node));
+      node = next;
+    }
+    while (retired_head_ != nullptr) {
+      Node* next = retired_head_->retired_next;
+      destroy_node(retired_head_);
+      retired_head_ = next;
+    }
+  }
+
+  // readers
+  ReadGuard read() const { return ReadGuard(*this); }
+
+  // writer methods; concurrent writers are serialized by a mutex
+  template <class... Args>
+  const_iterator emplace(const_iterator pos, Args&&... args) {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    return const_iterator(
+        emplace_before(pos.get_ptr(), std::forward<Args>(args)...));
+  }
+
+  void push_back(const T& value) {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    emplace_before(&root_, value);
+  }
+
+  void push_back(T&& value) {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    emplace_before(&root_, std::move(value));
+  }
+
+  void push_front(const T& value) {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    emplace_before(root_.next.load(std::memory_order_relaxed), value);
+  }
+
+  void erase(const_iterator pos) {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    unlink(pos.get_ptr());
+  }
+
+  void pop_front() {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    unlink(root_.next.load(std::memory_order_relaxed));
+  }
+
+  void pop_back() {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    unlink(root_.prev);
+  }
+
+  // erases every element satisfying pred in one writer pass
+  template <class Predicate>
+  size_t erase_if(Predicate pred) {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    size_t erased = 0;
+    BaseNode* node = root_.next.load(std::memory_order_relaxed);
+    while (node != &root_) {
+      BaseNode* next = node->next.load(std::memory_order_relaxed);
+      if (pred(std::as_const(static_cast<Node*>(node)->value))) {
+        unlink(node);
+        ++erased;
+      }
+      node = next;
+    }
+    return erased;
+  }
+
+  // frees whatever no reader can reach any more
+  size_t reclaim_retired() {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    return reclaim();
+  }
+
+  // blocks until every retired node has been freed
+  void synchronize() {
+    std::lock_guard<std::mutex> guard(writer_mutex_);
+    while (reclaim(), retired_head_ != nullptr) {
+      std::this_thread::yield();
+    }
+  }
+
+  // getters
+  node_allocator_type get_allocator() const { return node_alloc_; }
+
+  size_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  bool empty() const { return size() == 0; }
+};
@@ -0,0 +1,401 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+// Pointer that stores the distance from its own address to the pointee.
+// Both ends living in one mapping keeps it valid whatever address the
+// mapping gets in a particular process.
+template <class T>
+class OffsetPtr {
+ private:
+  // offset 0 points to the OffsetPtr itself, so 1 is used as null
+  static constexpr std::ptrdiff_t kNull = 1;
+
+  std::ptrdiff_t offset_ = kNull;
+
+  void set(const volatile void* ptr) noexcept {
+    offset_ = ptr == nullptr ? kNull
+                             : reinterpret_cast<std::uintptr_t>(ptr) -
+                                   reinterpret_cast<std::uintptr_t>(this);
+  }
+
+ public:
+  using element_type = T;
+  using difference_type = std::ptrdiff_t;
+
+  template <class U>
+  using rebind = OffsetPtr<U>;
+
+  // constructors
+  OffsetPtr() noexcept = default;
+
+  OffsetPtr(std::nullptr_t) noexcept {}
+
+  OffsetPtr(T* ptr) noexcept { set(ptr); }
+
+  OffsetPtr(const OffsetPtr& copy) noexcept { set(copy.get()); }
+
+  template <class U,
+            class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  OffsetPtr(const OffsetPtr<U>& copy) noexcept {
+    set(static_cast<T*>(copy.get()));
+  }
+
+  // operators
+  OffsetPtr& operator=(const OffsetPtr& copy) noexcept {
+    set(copy.get());
+    return *this;
+  }
+
+  OffsetPtr& operator=(T* ptr) noexcept {
+    set(ptr);
+    return *this;
+  }
+
+  OffsetPtr& operator=(std::nullptr_t) noexcept {
+    offset_ = kNull;
+    return *this;
+  }
+
+  template <class U = T>
+  std::add_lvalue_reference_t<U> operator*() const noexcept {
+    return *get();
+  }
+
+  T* operator->() const noexcept { return get(); }
+
+  explicit operator bool() const noexcept { return offset_ != kNull; }
+
+  template <class U = T>
+  static OffsetPtr pointer_to(U& ref) noexcept {
+    return OffsetPtr(std::addressof(ref));
+  }
+
+  T* get() const noexcept {
+    if (offset_ == kNull) {
+      return nullptr;
+    }
+    return reinterpret_cast<T*>(reinterpret_cast<std::uintptr_t>(this) +
+                                offset_);
+  }
+
+  friend bool operator==(const OffsetPtr& lhs, const OffsetPtr& rhs) {
+    return lhs.get() == rhs.get();
+  }
+
+  friend bool operator!=(const OffsetPtr& lhs, const OffsetPtr& rhs) {
+    return lhs.get() != rhs.get();
+  }
+
+  friend bool operator==(const OffsetPtr& lhs, std::nullptr_t) {
+    return !lhs;
+  }
+
+  friend bool operator!=(const OffsetPtr& lhs, std::nullptr_t) {
+    return static_cast<bool>(lhs);
+  }
+
+  friend bool operator<(const OffsetPtr& lhs, const OffsetPtr& rhs) {
+    return lhs.get() < rhs.get();
+  }
+};
+
+// Spin lock that works across processes as long as it lives in shared memory.
+class ShmSpinLock {
+ private:
+  std::atomic<uint32_t> locked_{0};
+
+  static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+ public:
+  void lock() noexcept {
+    while (locked_.exchange(1, std::memory_order_acquire) != 0) {
+      while (locked_.load(std::memory_order_relaxed) != 0) {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  bool try_lock() noexcept {
+    return locked_.exchange(1, std::memory_order_acquire) == 0;
+  }
+
+  void unlock() noexcept { locked_.store(0, std::memory_order_release); }
+};
+
+// Bump arena placed at the start of a shared segment. Freed blocks up to
+// kMaxCachedSize bytes are kept in per-size free lists, so a list that keeps
+// erasing and inserting nodes stays inside the segment.
+class ShmArena {
+ private:
+  static constexpr size_t kGranule = 16;
+  static constexpr size_t kClassCount = 32;
+  static constexpr size_t kMaxCachedSize = kGranule * kClassCount;
+  static constexpr uint64_t kMagic = 0x4c6973744172656eULL;
+
+  struct FreeBlock {
+    OffsetPtr<FreeBlock> next;
+  };
+
+  uint64_t magic_ = kMagic;
+  ShmSpinLock lock_;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  OffsetPtr<FreeBlock> free_[kClassCount];
+  OffsetPtr<void> root_;
+
+  explicit ShmArena(size_t capacity) : capacity_(capacity) {
+    used_ = header_size();
+  }
+
+  static constexpr size_t header_size() {
+    return (sizeof(ShmArena) + kGranule - 1) / kGranule * kGranule;
+  }
+
+  static size_t round_up(size_t bytes) {
+    return bytes == 0 ? kGranule : (bytes + kGranule - 1) / kGranule * kGranule;
+  }
+
+  static size_t class_of(size_t bytes) { return (bytes - 1) / kGranule; }
+
+  char* data() { return reinterpret_cast<char*>(this); }
+
+ public:
+  ShmArena(const ShmArena&) = delete;
+  ShmArena& operator=(const ShmArena&) = delete;
+
+  // memory must be at least kGranule aligned and outlive every user
+  static ShmArena* create(void* memory, size_t bytes) {
+    if (bytes < header_size()) {
+      throw std::bad_alloc();
+    }
+    return ::new (memory) ShmArena(bytes);
+  }
+
+  static ShmArena* attach(void* memory) {
+    auto* arena = static_cast<ShmArena*>(memory);
+    if (arena->magic_ != kMagic) {
+      throw std::runtime_error("ShmArena::attach: segment is not an arena");
+    }
+    return arena;
+  }
+
+  // bytes is the size of the caller's mapping: an arena formatted for more
+  // would hand out blocks past its end
+  static ShmArena* attach(void* memory, size_t bytes) {
+    if (bytes < header_size()) {
+      throw std::runtime_error("ShmArena::attach: mapping holds no arena");
+    }
+    ShmArena* arena = attach(memory);
+    if (arena->capacity_ > bytes) {
+      throw std::runtime_error("ShmArena::attach: arena exceeds the mapping");
+    }
+    return arena;
+  }
+
+  void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+    bytes = round_up(bytes);
+    std::lock_guard<ShmSpinLock> guard(lock_);
+    if (bytes <= kMaxCachedSize && alignment <= kGranule) {
+      OffsetPtr<FreeBlock>& head = free_[class_of(bytes)];
+      if (head) {
+        FreeBlock* block = head.get();
+        head = block->next;
+        return block;
+      }
+    }
+    uintptr_t begin = reinterpret_cast<uintptr_t>(data()) + used_;
+    uintptr_t aligned = (begin + alignment - 1) / alignment * alignment;
+    size_t end = aligned - reinterpret_cast<uintptr_t>(data()) + bytes;
+    if (end > capacity_) {
+      throw std::bad_alloc();
+    }
+    used_ = end;
+    return reinterpret_cast<void*>(aligned);
+  }
+
+  // over-aligned and large blocks are not reused until the arena is dropped
+  void deallocate(void* ptr, size_t bytes,
+                  size_t alignment = alignof(std::max_align_t)) noexcept {
+    bytes = round_up(bytes);
+    if (bytes > kMaxCachedSize || alignment > kGranule) {
+      return;
+    }
+    std::lock_guard<ShmSpinLock> guard(lock_);
+    FreeBlock* block = ::new (ptr) FreeBlock;
+    OffsetPtr<FreeBlock>& head = free_[class_of(bytes)];
+    block->next = head;
+    head = block;
+  }
+
+  template <class U, class... Args>
+  U* construct(Args&&... args) {
+    void* memory = allocate(sizeof(U), alignof(U));
+    try {
+      return ::new (memory) U(std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate(memory, sizeof(U), alignof(U));
+      throw;
+    }
+  }
+
+  // well-known object other processes look up after attach()
+  void set_root(void* root) noexcept { root_ = root; }
+
+  template <class U>
+  U* root() const noexcept {
+    return static_cast<U*>(root_.get());
+  }
+
+  size_t capacity() const noexcept { return capacity_; }
+
+  size_t used() const noexcept { return used_; }
+};
+
+template <class T>
+class ShmAllocator {
+ private:
+  template <class U>
+  friend class ShmAllocator;
+
+  OffsetPtr<ShmArena> arena_;
+
+ public:
+  using value_type = T;
+  using pointer = OffsetPtr<T>;
+  using const_pointer = OffsetPtr<const T>;
+  using void_pointer = OffsetPtr<void>;
+  using const_void_pointer = OffsetPtr<const void>;
+  using size_type = size_t;
+  using difference_type = std::ptrdiff_t;
+
+  template <class U>
+  struct rebind {
+    using other = ShmAllocator<U>;
+  };
+
+  // constructors
+  ShmAllocator(ShmArena* arena) noexcept : arena_(arena) {}
+
+  ShmAllocator(const ShmAllocator& copy) noexcept : arena_(copy.arena_) {}
+
+  template <class U>
+  ShmAllocator(const ShmAllocator<U>& copy) noexcept : arena_(copy.arena_) {}
+
+  ShmAllocator& operator=(const ShmAllocator& copy) noexcept {
+    arena_ = copy.arena_;
+    return *this;
+  }
+
+  // methods
+  pointer allocate(size_t n) {
+    if (n > SIZE_MAX / sizeof(T)) {
+      throw std::bad_array_new_length();
+    }
+    return pointer(
+        static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))));
+  }
+
+  void deallocate(pointer ptr, size_t n) noexcept {
+    arena_->deallocate(ptr.get(), n * sizeof(T), alignof(T));
+  }
+
+  ShmArena* arena() const noexcept { return arena_.get(); }
+
+  template <class U>
+  bool operator==(const ShmAllocator<U>& other) const noexcept {
+    return arena_.get() == other.arena_.get();
+  }
+
+  template <class U>
+  bool operator!=(const ShmAllocator<U>& other) const noexcept {
+    return !(*this == other);
+  }
+};
+
+// File backed MAP_SHARED mapping. Every process that opens the same path gets
+// its own view of one arena, usually at a different address.
+class ShmSegment {
+ private:
+  int fd_ = -1;
+  void* memory_ = nullptr;
+  size_t size_ = 0;
+
+  // errno is read before close, which may overwrite it
+  [[noreturn]] void fail(const char* what) {
+    int error = errno;
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+    throw std::system_error(error, std::generic_category(), what);
+  }
+
+ public:
+  // create == true truncates the file and formats a fresh arena in it
+  ShmSegment(const std::string& path, size_t size, bool create)
+      : size_(size) {
+    fd_ = ::open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR,
+                 0600);
+    if (fd_ < 0) {
+      fail("ShmSegment: open");
+    }
+    if (create && ::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      fail("ShmSegment: ftruncate");
+    }
+    if (!create) {
+      // touching a mapping past the end of the file raises SIGBUS
+      struct stat status;
+      if (::fstat(fd_, &status) != 0) {
+        fail("ShmSegment: fstat");
+      }
+      if (static_cast<uint64_t>(status.st_size) < size) {
+        errno = EINVAL;
+        fail("ShmSegment: file is smaller than size");
+      }
+    }
+    memory_ = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (memory_ == MAP_FAILED) {
+      fail("ShmSegment: mmap");
+    }
+    try {
+      if (create) {
+        ShmArena::create(memory_, size);
+      } else {
+        ShmArena::attach(memory_, size);
+      }
+    } catch (...) {
+      ::munmap(memory_, size_);
+      ::close(fd_);
+      throw;
+    }
+  }
+
+  ShmSegment(const ShmSegment&) = delete;
+  ShmSegment& operator=(const ShmSegment&) = delete;
+
+  ~ShmSegment() {
+    ::munmap(memory_, size_);
+    ::close(fd_);
+  }
+
+  ShmArena* arena() const { return ShmArena::attach(memory_, size_); }
+
+  void* data() const { return memory_; }
+
+  size_t size() const { return size_; }
+};
@@ -0,0 +1,109 @@
+#pragma once
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Small blocks carved from mmap'd slabs and recycled through free lists per
+// size class, as in NodePool; larger or over-aligned blocks get pages of
+// their own. Derived decides how memory is mapped by providing
+//   void* map_slab(size_t bytes);
+//   void* map_block(size_t bytes);
+// which return page-aligned memory that munmap releases. Slabs return to
+// the system only when the arena is destroyed. Not thread-safe.
+template <class Derived>
+class SlabArena {
+ public:
+  static constexpr size_t kGranule = alignof(std::max_align_t);
+  static constexpr size_t max_pooled_size = kGranule * 32;
+
+  explicit SlabArena(size_t slab_size) : slab_size_(slab_size) {}
+
+  SlabArena(const SlabArena&) = delete;
+  SlabArena& operator=(const SlabArena&) = delete;
+
+  ~SlabArena() {
+    for (void* slab : slabs_) {
+      munmap(slab, slab_size_);
+    }
+  }
+
+  void* allocate(size_t size, size_t alignment) {
+    if (size > max_pooled_size || alignment > kGranule) {
+      return derived().map_block(round_to_pages(size));
+    }
+    size_t index = class_of(size);
+    if (free_[index] != nullptr) {
+      FreeBlock* block = free_[index];
+      free_[index] = block->next;
+      return block;
+    }
+    size_t bytes = (index + 1) * kGranule;
+    if (cursor_ == nullptr || cursor_ + bytes > limit_) {
+      // room to record the slab first, so a mapped slab is never lost
+      slabs_.reserve(slabs_.size() + 1);
+      cursor_ = static_cast<char*>(derived().map_slab(slab_size_));
+      limit_ = cursor_ + slab_size_;
+      slabs_.push_back(cursor_);
+    }
+    void* block = cursor_;
+    cursor_ += bytes;
+    return block;
+  }
+
+  void deallocate(void* ptr, size_t size, size_t alignment) noexcept {
+    if (size > max_pooled_size || alignment > kGranule) {
+      munmap(ptr, round_to_pages(size));
+      return;
+    }
+    size_t index = class_of(size);
+    free_[index] = ::new (ptr) FreeBlock{free_[index]};
+  }
+
+  // getters
+  size_t slab_size() const { return slab_size_; }
+
+  size_t slab_count() const { return slabs_.size(); }
+
+  static size_t page_size() {
+    static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    return size;
+  }
+
+ protected:
+  const std::vector<void*>& slabs() const { return slabs_; }
+
+  // calls f with every freed block waiting for reuse
+  template <class F>
+  void for_each_free_block(F f) const {
+    for (FreeBlock* head : free_) {
+      for (FreeBlock* block = head; block != nullptr; block = block->next) {
+        f(static_cast<void*>(block));
+      }
+    }
+  }
+
+  static size_t round_to_pages(size_t size) {
+    return (size + page_size() - 1) / page_size() * page_size();
+  }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  size_t slab_size_;
+  std::vector<void*> slabs_;
+  char* cursor_ = nullptr;
+  char* limit_ = nullptr;
+  FreeBlock* free_[max_pooled_size / kGranule] = {};
+
+  Derived& derived() { return static_cast<Derived&>(*this); }
+
+  // a zero-byte block takes one granule, as in ShmArena
+  static size_t class_of(size_t size) {
+    return size == 0 ? 0 : (size - 1) / kGranule;
+  }
+};
@@ -0,0 +1,495 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Handle to a SlotMap element. It goes stale when the element is erased,
+// even if the slot is reused later.
+struct SlotMapHandle {
+  uint32_t index = UINT32_MAX;
+  uint32_t generation = 0;
+
+  bool operator==(const SlotMapHandle& other) const = default;
+};
+
+// Insertion-ordered container with List's iterator interface whose elements
+// live in one contiguous array of slots linked by prev/next indices. Erased
+// slots are reused, and a generation counter per slot tells live handles
+// from stale ones. Handles and iterators survive growth, but references to
+// elements do not: growing moves the values to a new array.
+template <class T, class Allocator = std::allocator<T>>
+class SlotMap {
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+
+  // base structures
+  // the generation is odd while the slot holds a value
+  class Slot {
+   public:
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+    uint32_t generation = 0;
+    union {
+      T value;
+    };
+
+    Slot() {}
+    ~Slot() {}
+
+    bool live() const { return (generation & 1) != 0; }
+  };
+
+ public:
+  // usings
+  using value_type = T;
+  using allocator_type = Allocator;
+  using handle_type = SlotMapHandle;
+
+ private:
+  using slot_allocator_type =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+  using slot_allocator_traits = std::allocator_traits<slot_allocator_type>;
+  using value_allocator_type =
+      typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+  using value_allocator_traits = std::allocator_traits<value_allocator_type>;
+
+  slot_allocator_type slot_alloc_;
+  Slot* slots_ = nullptr;
+  uint32_t capacity_ = 0;
+  // slots below used_ have been handed out at least once
+  uint32_t used_ = 0;
+  uint32_t free_ = kNil;
+  uint32_t head_ = kNil;
+  uint32_t tail_ = kNil;
+  size_t size_ = 0;
+
+ public:
+  // bytes of slot storage per element, to compare with List::node_size
+  static constexpr size_t slot_size = sizeof(Slot);
+
+  // iterator
+  template <bool IsConst>
+  class Iterator {
+   private:
+    using map_pointer =
+        std::conditional_t<IsConst, const SlotMap*, SlotMap*>;
+
+    map_pointer map_ = nullptr;
+    uint32_t index_ = kNil;
+
+    friend class SlotMap;
+
+   public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<IsConst, const T*, T*>;
+    using reference = std::conditional_t<IsConst, const T&, T&>;
+
+    // constructors
+    Iterator() = default;
+
+    Iterator(map_pointer map, uint32_t index) : map_(map), index_(index) {}
+
+    operator Iterator<true>() const
+      requires(!IsConst)
+    {
+      return Iterator<true>(map_, index_);
+    }
+
+    // operators
+    reference operator*() const { return map_->slots_[index_].value; }
+
+    pointer operator->() const { return &map_->slots_[index_].value; }
+
+    Iterator& operator++() {
+      index_ = map_->slots_[index_].next;
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator temp(*this);
+      ++(*this);
+      return temp;
+    }
+
+    // --end() is the last element
+    Iterator& operator--() {
+      index_ = index_ == kNil ? map_->tail_ : map_->slots_[index_].prev;
+      return *this;
+    }
+
+    Iterator operator--(int) {
+      Iterator temp(*this);
+      --(*this);
+      return temp;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return index_ == other.index_;
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return index_ != other.index_;
+    }
+  };
+
+  // usings for iterators
+  using iterator = Iterator<false>;
+  using const_iterator = Iterator<true>;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+ private:
+  // storage
+  // make_first fills slot used_ of the new array before the old values move,
+  // so an argument referring into the map is still intact when it runs
+  template <class MakeFirst>
+  void grow(MakeFirst&& make_first) {
+    uint32_t capacity = capacity_ == 0 ? 8 : capacity_ * 2;
+    Slot* slots = slot_allocator_traits::allocate(slot_alloc_, capacity);
+    for (uint32_t i = 0; i < capacity; ++i) {
+      std::construct_at(slots + i);
+    }
+    value_allocator_type value_alloc(slot_alloc_);
+    try {
+      make_first(slots[used_]);
+    } catch (...) {
+      release(slots, capacity);
+      throw;
+    }
+    uint32_t moved = 0;
+    try {
+      for (; moved < used_; ++moved) {
+        Slot& from = slots_[moved];
+        Slot& to = slots[moved];
+        to.prev = from.prev;
+        to.next = from.next;
+        to.generation = from.generation;
+        if (from.live()) {
+          value_allocator_traits::construct(value_alloc, &to.value,
+                                            std::move_if_noexcept(from.value));
+        }
+      }
+    } catch (...) {
+      for (uint32_t i = 0; i < moved; ++i) {
+        if (slots[i].live()) {
+          value_allocator_traits::destroy(value_alloc, &slots[i].value);
+        }
+      }
+      if (slots[used_].live()) {
+        value_allocator_traits::destroy(value_alloc, &slots[used_].value);
+      }
+      release(slots, capacity);
+      throw;
+    }
+    destroy_values();
+    release(slots_, capacity_);
+    slots_ = slots;
+    capacity_ = capacity;
+  }
+
+  void destroy_values() {
+    value_allocator_type value_alloc(slot_alloc_);
+    for (uint32_t index = head_; index != kNil; index = slots_[index].next) {
+      value_allocator_traits::destroy(value_alloc, &slots_[index].value);
+    }
+  }
+
+  void release(Slot* slots, uint32_t capacity) {
+    if (slots == nullptr) {
+      return;
+    }
+    for (uint32_t i = 0; i < capacity; ++i) {
+      std::destroy_at(slots + i);
+    }
+    slot_allocator_traits::deallocate(slot_alloc_, slots, capacity);
+  }
+
+  // constructs the value in a free slot and links it in front of pos
+  template <class... Args>
+  handle_type emplace_before(uint32_t pos, Args&&... args) {
+    value_allocator_type value_alloc(slot_alloc_);
+    auto make_value = [&](Slot& slot) {
+      value_allocator_traits::construct(value_alloc, &slot.value,
+                                        std::forward<Args>(args)...);
+      ++slot.generation;
+    };
+    uint32_t index = free_;
+    if (index != kNil) {
+      make_value(slots_[index]);
+      free_ = slots_[index].next;
+    } else {
+      if (used_ == capacity_) {
+        grow(make_value);
+      } else {
+        make_value(slots_[used_]);
+      }
+      index = used_++;
+    }
+    Slot& slot = slots_[index];
+    slot.next = pos;
+    slot.prev = pos == kNil ? tail_ : slots_[pos].prev;
+    (slot.prev == kNil ? head_ : slots_[slot.prev].next) = index;
+    (pos == kNil ? tail_ : slots_[pos].prev) = index;
+    ++size_;
+    return handle_type{index, slot.generation};
+  }
+
+  void erase_index(uint32_t index) {
+    Slot& slot = slots_[index];
+    (slot.prev == kNil ? head_ : slots_[slot.prev].next) = slot.next;
+    (slot.next == kNil ? tail_ : slots_[slot.next].prev) = slot.prev;
+    value_allocator_type value_alloc(slot_alloc_);
+    value_allocator_traits::destroy(value_alloc, &slot.value);
+    ++slot.generation;
+    slot.next = free_;
+    free_ = index;
+    --size_;
+  }
+
+  bool valid(handle_type handle) const {
+    return handle.index < used_ &&
+           slots_[handle.index].generation == handle.generation &&
+           slots_[handle.index].live();
+  }
+
+  void swap_storage(SlotMap& other) {
+    std::swap(slots_, other.slots_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(used_, other.used_);
+    std::swap(free_, other.free_);
+    std::swap(head_, other.head_);
+    std::swap(tail_, other.tail_);
+    std::swap(size_, other.size_);
+  }
+
+ public:
+  // constructors
+  explicit SlotMap(const Allocator& alloc = Allocator()) : slot_alloc_(alloc) {}
+
+  SlotMap(std::initializer_list<T> init, const Allocator& alloc = Allocator())
+      : slot_alloc_(alloc) {
+    try {
+      for (const T& value : init) {
+        push_back(value);
+      }
+    } catch (...) {
+      clear();
+      release(slots_, capacity_);
+      throw;
+    }
+  }
+
+  // the copy keeps the slot indices, so handles are valid in both maps
+  SlotMap(const SlotMap& copy)
+      : slot_alloc_(slot_allocator_traits::select_on_container_copy_construction(
+            copy.slot_alloc_)) {
+    copy_slots(copy);
+  }
+
+  SlotMap(SlotMap&& other) noexcept
+      : slot_alloc_(std::move(other.slot_alloc_)) {
+    swap_storage(other);
+  }
+
+  // destructor
+  ~SlotMap() {
+    destroy_values();
+    release(slots_, capacity_);
+  }
+
+  // operators
+  SlotMap& operator=(const SlotMap& copy) {
+    if (this == &copy) {
+      return *this;
+    }
+    SlotMap temp(slot_allocator_traits::propagate_on_container_copy_assignment::
+                         value
+                     ? copy.slot_alloc_
+                     : slot_alloc_);
+    temp.copy_slots(copy);
+    std::swap(slot_alloc_, temp.slot_alloc_);
+    swap_storage(temp);
+    return *this;
+  }
+
+  // takes the slots over when the allocator propagates or compares equal;
+  // otherwise moves the values into slots of our own at the same indices.
+  // Either way the handles of other are valid here, and other is left empty
+  SlotMap& operator=(SlotMap&& other) noexcept(
+      slot_allocator_traits::propagate_on_container_move_assignment::value ||
+      slot_allocator_traits::is_always_equal::value) {
+    if (this == &other) {
+      return *this;
+    }
+    constexpr bool kPropagate =
+        slot_allocator_traits::propagate_on_container_move_assignment::value;
+    if (kPropagate || slot_alloc_ == other.slot_alloc_) {
+      destroy_values();
+      release(slots_, capacity_);
+      slots_ = nullptr;
+      capacity_ = 0;
+      used_ = 0;
+      free_ = head_ = tail_ = kNil;
+      size_ = 0;
+      if constexpr (kPropagate) {
+        slot_alloc_ = std::move(other.slot_alloc_);
+      }
+      swap_storage(other);
+      return *this;
+    }
+    SlotMap temp(slot_alloc_);
+    temp.copy_slots(std::move(other));
+    swap_storage(temp);
+    other.clear();
+    return *this;
+  }
+
+  // methods
+  handle_type push_back(const T& value) { return emplace_before(kNil, value); }
+
+  handle_type push_back(T&& value) {
+    return emplace_before(kNil, std::move(value));
+  }
+
+  template <class... Args>
+  handle_type emplace_back(Args&&... args) {
+    return emplace_before(kNil, std::forward<Args>(args)...);
+  }
+
+  handle_type push_front(const T& value) {
+    return emplace_before(head_, value);
+  }
+
+  handle_type insert(const_iterator pos, const T& value) {
+    return emplace_before(pos.index_, value);
+  }
+
+  void erase(const_iterator pos) { erase_index(pos.index_); }
+
+  // false when the handle is stale
+  bool erase(handle_type handle) {
+    if (!valid(handle)) {
+      return false;
+    }
+    erase_index(handle.index);
+    return true;
+  }
+
+  void pop_front() { erase_index(head_); }
+
+  void pop_back() { erase_index(tail_); }
+
+  void clear() {
+    while (head_ != kNil) {
+      erase_index(head_);
+    }
+  }
+
+  void reserve(size_t count) {
+    while (capacity_ < count) {
+      grow([](Slot&) {});
+    }
+  }
+
+  // handle lookup
+  T* get(handle_type handle) {
+    return valid(handle) ? &slots_[handle.index].value : nullptr;
+  }
+
+  const T* get(handle_type handle) const {
+    return valid(handle) ? &slots_[handle.index].value : nullptr;
+  }
+
+  bool contains(handle_type handle) const { return valid(handle); }
+
+  iterator find(handle_type handle) {
+    return iterator(this, valid(handle) ? handle.index : kNil);
+  }
+
+  handle_type handle_of(const_iterator pos) const {
+    return handle_type{pos.index_, slots_[pos.index_].generation};
+  }
+
+  iterator begin() { return iterator(this, head_); }
+
+  iterator end() { return iterator(this, kNil); }
+
+  const_iterator begin() const { return const_iterator(this, head_); }
+
+  const_iterator end() const { return const_iterator(this, kNil); }
+
+  const_iterator cbegin() const { return const_iterator(this, head_); }
+
+  const_iterator cend() const { return const_iterator(this, kNil); }
+
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+
+  const_reverse_iterator crbegin() const {
+    return const_reverse_iterator(cend());
+  }
+
+  const_reverse_iterator crend() const {
+    return const_reverse_iterator(cbegin());
+  }
+
+  // getters
+  allocator_type get_allocator() const { return allocator_type(slot_alloc_); }
+
+  size_t size() const { return size_; }
+
+  bool empty() const { return size_ == 0; }
+
+  size_t capacity() const { return capacity_; }
+
+ private:
+  // *this is empty; copies slot for slot, free list included. The values
+  // are moved when copy is an rvalue
+  template <class Source>
+  void copy_slots(Source&& copy) {
+    constexpr bool kMove = !std::is_lvalue_reference_v<Source>;
+    reserve(copy.used_);
+    value_allocator_type value_alloc(slot_alloc_);
+    uint32_t index = 0;
+    try {
+      for (; index < copy.used_; ++index) {
+        auto& from = copy.slots_[index];
+        if (from.live()) {
+          if constexpr (kMove) {
+            value_allocator_traits::construct(
+                value_alloc, &slots_[index].value, std::move(from.value));
+          } else {
+            value_allocator_traits::construct(
+                value_alloc, &slots_[index].value, from.value);
+          }
+        }
+        slots_[index].prev = from.prev;
+        slots_[index].next = from.next;
+        slots_[index].generation = from.generation;
+      }
+    } catch (...) {
+      for (uint32_t i = 0; i < index; ++i) {
+        if (slots_[i].live()) {
+          value_allocator_traits::destroy(value_alloc, &slots_[i].value);
+        }
+        slots_[i].generation = 0;
+      }
+      release(slots_, capacity_);
+      slots_ = nullptr;
+      capacity_ = 0;
+      throw;
+    }
+    used_ = copy.used_;
+    free_ = copy.free_;
+    head_ = copy.head_;
+    tail_ = copy.tail_;
+    size_ = copy.size_;
+  }
+};
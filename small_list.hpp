@@ -0,0 +1,245 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "list.hpp"
+
+// Fixed pool of node-sized slots embedded in the owning object.
+template <size_t SlotSize, size_t SlotAlign, size_t Count>
+class InlineNodeArena {
+ private:
+  union Slot {
+    Slot* next;
+    alignas(SlotAlign) unsigned char bytes[SlotSize];
+  };
+
+  Slot slots_[Count];
+  Slot* free_ = nullptr;
+  size_t untouched_ = 0;
+
+ public:
+  static constexpr size_t slot_size = SlotSize;
+  static constexpr size_t slot_alignment = SlotAlign;
+
+  InlineNodeArena() = default;
+  InlineNodeArena(const InlineNodeArena&) = delete;
+  InlineNodeArena& operator=(const InlineNodeArena&) = delete;
+
+  void* try_allocate() noexcept {
+    if (free_ != nullptr) {
+      Slot* slot = free_;
+      free_ = slot->next;
+      return slot;
+    }
+    if (untouched_ < Count) {
+      return &slots_[untouched_++];
+    }
+    return nullptr;
+  }
+
+  bool owns(const void* ptr) const noexcept {
+    auto* slot = static_cast<const Slot*>(ptr);
+    return std::less_equal<const Slot*>()(slots_, slot) &&
+           std::less<const Slot*>()(slot, slots_ + Count);
+  }
+
+  void deallocate(void* ptr) noexcept {
+    Slot* slot = static_cast<Slot*>(ptr);
+    slot->next = free_;
+    free_ = slot;
+  }
+};
+
+// Serves single node allocations from an InlineNodeArena and forwards the
+// rest to Upstream. A copy made for container copy construction has no arena,
+// so a List copied out of a SmallList never points into someone else's slots.
+template <class T, class Arena, class Upstream>
+class InlineNodeAllocator {
+ private:
+  template <class U, class OtherArena, class OtherUpstream>
+  friend class InlineNodeAllocator;
+
+  using upstream_traits = std::allocator_traits<Upstream>;
+
+  Arena* arena_ = nullptr;
+  Upstream upstream_;
+
+  static constexpr bool kFitsSlot = sizeof(T) <= Arena::slot_size &&
+                                    alignof(T) <= Arena::slot_alignment;
+
+ public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::false_type;
+  using propagate_on_container_swap = std::false_type;
+  using is_always_equal = std::false_type;
+
+  template <class U>
+  struct rebind {
+    using other = InlineNodeAllocator<
+        U, Arena, typename upstream_traits::template rebind_alloc<U>>;
+  };
+
+  // constructors
+  InlineNodeAllocator(Arena* arena, const Upstream& upstream)
+      : arena_(arena), upstream_(upstream) {}
+
+  template <class U, class OtherUpstream>
+  InlineNodeAllocator(
+      const InlineNodeAllocator<U, Arena, OtherUpstream>& other)
+      : arena_(other.arena_), upstream_(other.upstream_) {}
+
+  // methods
+  T* allocate(size_t n) {
+    if constexpr (kFitsSlot) {
+      if (n == 1 && arena_ != nullptr) {
+        if (void* slot = arena_->try_allocate()) {
+          return static_cast<T*>(slot);
+        }
+      }
+    }
+    return std::to_address(upstream_traits::allocate(upstream_, n));
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    if constexpr (kFitsSlot) {
+      if (arena_ != nullptr && arena_->owns(ptr)) {
+        arena_->deallocate(ptr);
+        return;
+      }
+    }
+    upstream_traits::deallocate(upstream_, ptr, n);
+  }
+
+  template <class U, class... Args>
+  void construct(U* ptr, Args&&... args) {
+    upstream_traits::construct(upstream_, ptr, std::forward<Args>(args)...);
+  }
+
+  template <class U>
+  void destroy(U* ptr) {
+    upstream_traits::destroy(upstream_, ptr);
+  }
+
+  InlineNodeAllocator select_on_container_copy_construction() const {
+    return InlineNodeAllocator(
+        nullptr,
+        upstream_traits::select_on_container_copy_construction(upstream_));
+  }
+
+  Upstream upstream() const { return upstream_; }
+
+  template <class U, class OtherUpstream>
+  bool operator==(
+      const InlineNodeAllocator<U, Arena, OtherUpstream>& other) const {
+    return arena_ == other.arena_ && upstream_ == other.upstream_;
+  }
+
+  template <class U, class OtherUpstream>
+  bool operator!=(
+      const InlineNodeAllocator<U, Arena, OtherUpstream>& other) const {
+    return !(*this == other);
+  }
+};
+
+// Holds the arena in a base so it is constructed before the List base that
+// allocates from it.
+template <class Arena>
+class SmallListStorage {
+ protected:
+  Arena arena_;
+};
+
+template <class T, size_t N, class Allocator>
+using SmallListArena =
+    InlineNodeArena<List<T, Allocator>::node_size,
+                    List<T, Allocator>::node_alignment, N + 1>;
+
+template <class T, size_t N, class Allocator>
+using SmallListBase =
+    List<T, InlineNodeAllocator<T, SmallListArena<T, N, Allocator>,
+                                Allocator>>;
+
+// List that keeps the sentinel and the first N nodes inside the object and
+// only spills to Allocator past that. Nodes never move while they are in the
+// list, so iterators stay valid exactly as for List. Moving a SmallList moves
+// the elements one by one, since inline nodes cannot change owner.
+template <class T, size_t N, class Allocator = std::allocator<T>>
+class SmallList : private SmallListStorage<SmallListArena<T, N, Allocator>>,
+                  public SmallListBase<T, N, Allocator> {
+ private:
+  using base_type = SmallListBase<T, N, Allocator>;
+  using inline_allocator_type = typename base_type::allocator_type;
+
+  inline_allocator_type make_allocator(const Allocator& alloc) {
+    return inline_allocator_type(&this->arena_, alloc);
+  }
+
+  Allocator upstream() const {
+    return base_type::get_allocator().upstream();
+  }
+
+ public:
+  static constexpr size_t inline_capacity = N;
+
+  // constructors
+  explicit SmallList(const Allocator& alloc = Allocator())
+      : base_type(make_allocator(alloc)) {}
+
+  explicit SmallList(size_t count, const Allocator& alloc = Allocator())
+      : base_type(count, make_allocator(alloc)) {}
+
+  SmallList(std::initializer_list<T> init,
+            const Allocator& alloc = Allocator())
+      : base_type(init, make_allocator(alloc)) {}
+
+  SmallList(size_t count, const T& value, const Allocator& alloc = Allocator())
+      : base_type(count, value, make_allocator(alloc)) {}
+
+  SmallList(const SmallList& copy)
+      : base_type(make_allocator(
+            std::allocator_traits<Allocator>::
+                select_on_container_copy_construction(copy.upstream()))) {
+    try {
+      for (auto iter = copy.cbegin(); iter != copy.cend(); ++iter) {
+        base_type::push_back(*iter);
+      }
+    } catch (...) {
+      base_type::clear();
+      throw;
+    }
+  }
+
+  SmallList(SmallList&& other) : base_type(make_allocator(other.upstream())) {
+    try {
+      while (!other.empty()) {
+        base_type::push_back(std::move(*other.begin()));
+        other.pop_front();
+      }
+    } catch (...) {
+      base_type::clear();
+      throw;
+    }
+  }
+
+  // operators
+  SmallList& operator=(const SmallList& copy) {
+    base_type::operator=(copy);
+    return *this;
+  }
+
+  SmallList& operator=(SmallList&& other) {
+    if (this != &other) {
+      base_type::clear();
+      while (!other.empty()) {
+        base_type::push_back(std::move(*other.begin()));
+        other.pop_front();
+      }
+    }
+    return *this;
+  }
+};
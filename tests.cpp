@@ -1,7 +1,20 @@
 #include <gtest/gtest.h>
+#include <cstring>
+#include <list>
+#include <sstream>
+#include <thread>
+#include "budget_allocator.hpp"
+#include "channel.hpp"
+#include "huge_page_allocator.hpp"
 #include "list.hpp"
+#include "lru_cache.hpp"
+#include "rcu_list.hpp"
+#include "shm_allocator.hpp"
+#include "slot_map.hpp"
+#include "small_list.hpp"
 #include "utils.hpp"
 #include "memory_utils.hpp"
+#include "numa_allocator.hpp"
 
 size_t MemoryManager::type_new_allocated = 0;
 size_t MemoryManager::type_new_deleted = 0;
@@ -9,6 +22,7 @@ size_t MemoryManager::allocator_allocated = 0;
 size_t MemoryManager::allocator_deallocated = 0;
 size_t MemoryManager::allocator_constructed = 0;
 size_t MemoryManager::allocator_destroyed = 0;
+size_t MemoryManager::allocator_calls = 0;
 
 template <typename T, bool PropagateOnConstruct, bool PropagateOnAssign>
 size_t
@@ -26,6 +40,7 @@ void SetupTest() {
   MemoryManager::allocator_deallocated = 0;
   MemoryManager::allocator_constructed = 0;
   MemoryManager::allocator_destroyed = 0;
+  MemoryManager::allocator_calls = 0;
 }
 
 template <typename Iterator, typename T>
@@ -213,6 +228,68 @@ TEST(Operators, AssignOperator) {
   }
 }
 
+// stateful allocator that stays with its list on move assignment
+template <class T>
+struct TaggedAllocator : std::allocator<T> {
+  using propagate_on_container_move_assignment = std::false_type;
+  using is_always_equal = std::false_type;
+
+  template <class U>
+  struct rebind {
+    using other = TaggedAllocator<U>;
+  };
+
+  int tag = 0;
+
+  TaggedAllocator(int tag = 0) : tag(tag) {}
+
+  template <class U>
+  TaggedAllocator(const TaggedAllocator<U>& other) : tag(other.tag) {}
+
+  template <class U>
+  bool operator==(const TaggedAllocator<U>& other) const {
+    return tag == other.tag;
+  }
+};
+
+TEST(Operators, MoveAssignOperator) {
+  SetupTest();
+  {
+    // the counting allocators differ, so the values move, uncopied
+    List<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> l1 = {1, 2, 3};
+    List<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> l2 = {4};
+    l2 = std::move(l1);
+    ASSERT_TRUE(l1.empty() && l2.size() == 3);
+    for (auto& value : l2) {
+      ASSERT_TRUE(*value.copy_c == 1);
+    }
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+
+  // a propagating allocator moves along with the nodes
+  List<int, WhimsicalAllocator<int, false, false>> whimsical_a = {1, 2};
+  List<int, WhimsicalAllocator<int, false, false>> whimsical_b;
+  auto alloc = whimsical_a.get_allocator();
+  whimsical_b = std::move(whimsical_a);
+  ASSERT_TRUE(whimsical_b.get_allocator() == alloc && whimsical_b.size() == 2);
+
+  // an equal allocator that does not propagate still lets the nodes go
+  List<std::string, TaggedAllocator<std::string>> same_a({"a", "b"}, 1);
+  List<std::string, TaggedAllocator<std::string>> same_b({"c"}, 1);
+  const std::string* first = &*same_a.begin();
+  same_b = std::move(same_a);
+  ASSERT_TRUE(&*same_b.begin() == first && same_a.empty());
+
+  // an unequal one keeps its allocator and moves the values over
+  List<std::string, TaggedAllocator<std::string>> other({"x", "y", "z"}, 2);
+  same_b = std::move(other);
+  ASSERT_TRUE(same_b.get_allocator().tag == 1 && other.empty());
+  ASSERT_TRUE(
+      (std::vector<std::string>(same_b.begin(), same_b.end()) ==
+       std::vector<std::string>{"x", "y", "z"}));
+}
+
 TEST(List, BasicFunc) {
   SetupTest();
   List<int> lst;
@@ -306,6 +383,19 @@ TEST(List, TestAccountant) {
   ASSERT_TRUE(Accountant::dtor_calls == 13);
 }
 
+TEST(List, EmptyListIterators) {
+  List<int> lst;
+  ASSERT_TRUE(lst.begin() == lst.end() && lst.cbegin() == lst.cend());
+  for (int value : lst) {
+    FAIL() << value;
+  }
+  lst.push_front(2);
+  lst.insert(lst.begin(), 1);
+  lst.clear();
+  lst.insert(lst.end(), 3);
+  ASSERT_TRUE(lst.size() == 1 && *lst.begin() == 3);
+}
+
 TEST(List, ExceptionSafety) {
   Accountant::reset();
 
@@ -346,6 +436,1211 @@ TEST(List, ExceptionSafety) {
   }
 }
 
+TEST(FancyPointers, ListSurvivesRelocation) {
+  using ShmList = List<int, ShmAllocator<int>>;
+  constexpr size_t kArenaSize = 1 << 16;
+  alignas(64) static char first[kArenaSize];
+  alignas(64) static char second[kArenaSize];
+
+  ShmArena* arena = ShmArena::create(first, kArenaSize);
+  auto* lst = arena->construct<ShmList>(ShmAllocator<int>(arena));
+  arena->set_root(lst);
+  for (int i = 0; i < 10; ++i) {
+    lst->push_back(i);
+  }
+  lst->pop_front();
+  lst->push_front(42);
+
+  // same bytes at another address, as a second process would map them
+  std::memcpy(second, first, kArenaSize);
+  auto* moved = ShmArena::attach(second)->root<ShmList>();
+  ASSERT_TRUE(moved->size() == 10);
+  ASSERT_TRUE(AreListsEqual(*lst, *moved));
+  for (auto& value : *moved) {
+    ASSERT_TRUE(reinterpret_cast<char*>(&value) >= second);
+    ASSERT_TRUE(reinterpret_cast<char*>(&value) < second + kArenaSize);
+  }
+  lst->~ShmList();
+}
+
+TEST(FancyPointers, ArenaReusesFreedNodes) {
+  constexpr size_t kArenaSize = 1 << 12;
+  alignas(64) static char buffer[kArenaSize];
+
+  ShmArena* arena = ShmArena::create(buffer, kArenaSize);
+  List<int, ShmAllocator<int>> lst{ShmAllocator<int>(arena)};
+  for (int round = 0; round < 1000; ++round) {
+    lst.push_back(round);
+    lst.push_back(round);
+    lst.pop_front();
+    lst.pop_front();
+  }
+  ASSERT_TRUE(lst.empty());
+  ASSERT_TRUE(arena->used() < kArenaSize / 2);
+}
+
+TEST(FancyPointers, SegmentFailuresReleaseResources) {
+  // the lowest free descriptor comes back only if no failure leaked one
+  int free_fd = ::dup(0);
+  ::close(free_fd);
+  std::string path = "/tmp/list_shm_segment_test";
+  // too small for the arena header
+  ASSERT_THROW(ShmSegment(path, 8, true), std::bad_alloc);
+  // a character device cannot be truncated
+  try {
+    ShmSegment segment("/dev/null", 4096, true);
+    FAIL();
+  } catch (const std::system_error& error) {
+    ASSERT_TRUE(error.code().value() == EINVAL);
+  }
+  {
+    ShmSegment segment(path, 1 << 16, true);
+    // attaching past the end of the file would fault on first touch
+    try {
+      ShmSegment view(path, 1 << 17, false);
+      FAIL();
+    } catch (const std::system_error& error) {
+      ASSERT_TRUE(error.code().value() == EINVAL);
+    }
+    // a view smaller than the arena would let it allocate past the view
+    ASSERT_THROW(ShmSegment(path, 1 << 12, false), std::runtime_error);
+    ShmSegment view(path, 1 << 16, false);
+    ASSERT_TRUE(view.arena()->capacity() == 1 << 16);
+    ShmAllocator<int> alloc(segment.arena());
+    ASSERT_THROW(alloc.allocate(SIZE_MAX / 2), std::bad_array_new_length);
+  }
+  int probe = ::dup(0);
+  ::close(probe);
+  ASSERT_TRUE(probe == free_fd);
+  std::remove(path.c_str());
+}
+
+TEST(Bulk, PushBackBulk) {
+  SetupTest();
+  std::vector<int> values = {1, 2, 3, 4, 5};
+  List<int, AllocatorWithCount<int>> lst = {0};
+  lst.push_back_bulk(values);
+  lst.push_back_bulk({});
+
+  ASSERT_TRUE(lst.size() == 6);
+  ASSERT_TRUE(MemoryManager::allocator_constructed == 6);
+  ASSERT_TRUE(AreListsEqual(lst, List<int>({0, 1, 2, 3, 4, 5})));
+}
+
+TEST(Bulk, EmplaceBackN) {
+  SetupTest();
+  List<TypeWithCounts> lst;
+  TypeWithCounts value(7);
+  lst.emplace_back_n(4, value);
+  lst.emplace_back_n(0, value);
+
+  ASSERT_TRUE(lst.size() == 4);
+  ASSERT_TRUE(*value.copy_c == 4);
+  for (auto& element : lst) {
+    ASSERT_TRUE(element.value == 7);
+  }
+}
+
+TEST(Bulk, PopFrontN) {
+  SetupTest();
+  {
+    List<int, AllocatorWithCount<int>> lst = {1, 2, 3, 4, 5};
+    std::vector<int> out;
+    lst.pop_front_n(2, std::back_inserter(out));
+    ASSERT_TRUE(lst.size() == 3);
+    ASSERT_TRUE(out == std::vector<int>({1, 2}));
+
+    lst.pop_front_n(10, std::back_inserter(out));
+    ASSERT_TRUE(lst.empty());
+    ASSERT_TRUE(out == std::vector<int>({1, 2, 3, 4, 5}));
+
+    lst.push_back(6);
+    ASSERT_TRUE(*lst.begin() == 6);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+  ASSERT_TRUE(MemoryManager::allocator_constructed ==
+              MemoryManager::allocator_destroyed);
+}
+
+TEST(Bulk, ExceptionSafety) {
+  ThrowingAccountant::need_throw = false;
+  List<ThrowingAccountant> lst(2);
+  std::vector<ThrowingAccountant> values(5);
+
+  Accountant::reset();
+  ThrowingAccountant::need_throw = true;
+  try {
+    lst.push_back_bulk(values);
+    FAIL();
+  } catch (const std::string&) {
+    ASSERT_TRUE(Accountant::ctor_calls == 4);
+    ASSERT_TRUE(Accountant::dtor_calls == 4);
+  }
+  ThrowingAccountant::need_throw = false;
+  ASSERT_TRUE(lst.size() == 2);
+}
+
+TEST(SmallList, NoHeapWhileSmall) {
+  SetupTest();
+  {
+    SmallList<int, 8, AllocatorWithCount<int>> lst;
+    for (int i = 0; i < 8; ++i) {
+      lst.push_back(i);
+    }
+    lst.pop_front();
+    lst.push_front(0);
+    ASSERT_TRUE(lst.size() == 8);
+    ASSERT_TRUE(MemoryManager::allocator_allocated == 0);
+    ASSERT_TRUE(MemoryManager::allocator_constructed == 9);
+
+    auto first = lst.begin();
+    lst.push_back(8);
+    ASSERT_TRUE(MemoryManager::allocator_allocated != 0);
+    ASSERT_TRUE(first == lst.begin());
+    ASSERT_TRUE(*first == 0);
+
+    SmallList<int, 8, AllocatorWithCount<int>> copy(lst);
+    ASSERT_TRUE(AreListsEqual(lst, copy));
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(SmallList, CopyAndMove) {
+  using SmallCounts =
+      SmallList<TypeWithCounts, 4, AllocatorWithCount<TypeWithCounts>>;
+  SetupTest();
+  {
+    SmallCounts lst = {1, 2, 3};
+    SmallCounts copy = lst;
+    ASSERT_TRUE(AreListsEqual(lst, copy));
+    ASSERT_TRUE(MemoryManager::allocator_allocated == 0);
+
+    size_t moves_before = *lst.begin()->move_c;
+    auto moved = std::move(lst);
+    ASSERT_TRUE(lst.empty());
+    ASSERT_TRUE(moved.size() == 3);
+    ASSERT_TRUE(*moved.begin()->move_c == moves_before + 1);
+    ASSERT_TRUE(*moved.begin()->copy_c == 2);
+
+    // strong guarantee keeps old and new elements alive at once, which spills
+    copy = moved;
+    copy.push_back(4);
+    copy = std::move(moved);
+    ASSERT_TRUE(copy.size() == 3);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+struct alignas(64) OverAligned {
+  int value = 0;
+};
+
+struct Huge {
+  Huge(int value = 0) : value(value) {}
+
+  int value;
+  char payload[1024];
+};
+
+template <>
+struct ListNodeLayout<Huge> {
+  static constexpr bool value_out_of_line = true;
+};
+
+TEST(NodeLayout, OverAlignedValue) {
+  ASSERT_TRUE(List<OverAligned>::node_alignment == 64);
+
+  List<OverAligned> lst(5);
+  for (auto& value : lst) {
+    ASSERT_TRUE(reinterpret_cast<uintptr_t>(&value) % 64 == 0);
+  }
+}
+
+TEST(NodeLayout, HugeValueOutOfLine) {
+  ASSERT_TRUE(List<Huge>::node_size <= 4 * sizeof(void*));
+  ASSERT_TRUE(List<int>::node_size == 3 * sizeof(void*));
+
+  SetupTest();
+  {
+    List<Huge, AllocatorWithCount<Huge>> lst = {1, 2, 3};
+    lst.push_front(0);
+    lst.insert(lst.end());
+    lst.erase(lst.begin());
+    ASSERT_TRUE(lst.size() == 4);
+    int expected[] = {1, 2, 3, 0};
+    int i = 0;
+    for (auto& value : lst) {
+      ASSERT_TRUE(value.value == expected[i++]);
+    }
+    ASSERT_TRUE(MemoryManager::allocator_constructed == 5);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_destroyed == 5);
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(RcuList, WriterOperations) {
+  SetupTest();
+  {
+    RcuList<int, AllocatorWithCount<int>> lst;
+    for (int i = 0; i < 5; ++i) {
+      lst.push_back(i);
+    }
+    lst.push_front(-1);
+    lst.pop_back();
+    lst.erase_if([](int value) { return value % 2 == 1; });
+
+    auto guard = lst.read();
+    std::vector<int> seen(guard.begin(), guard.end());
+    ASSERT_TRUE(seen == std::vector<int>({-1, 0, 2}));
+    ASSERT_TRUE(lst.size() == 3);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_constructed ==
+              MemoryManager::allocator_destroyed);
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(RcuList, ReaderDelaysReclamation) {
+  SetupTest();
+  RcuList<int, AllocatorWithCount<int>> lst;
+  lst.push_back(1);
+  lst.push_back(2);
+  {
+    auto guard = lst.read();
+    auto iter = guard.begin();
+    lst.pop_front();
+    ASSERT_TRUE(lst.reclaim_retired() == 0);
+    ASSERT_TRUE(*iter == 1);
+    ++iter;
+    ASSERT_TRUE(*iter == 2);
+  }
+  ASSERT_TRUE(lst.reclaim_retired() == 1);
+  ASSERT_TRUE(MemoryManager::allocator_destroyed == 1);
+}
+
+TEST(RcuList, ConcurrentReaders) {
+  constexpr int kReaders = 4;
+  constexpr int kValues = 64;
+  RcuList<int> lst;
+  for (int i = 0; i < kValues; ++i) {
+    lst.push_back(i);
+  }
+
+  std::atomic<bool> stop{false};
+  std::atomic<bool> corrupted{false};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < kReaders; ++r) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        auto guard = lst.read();
+        for (int value : guard) {
+          if (value < 0 || value >= kValues) {
+            corrupted = true;
+          }
+        }
+      }
+    });
+  }
+  for (int round = 0; round < 20000; ++round) {
+    int value = round % kValues;
+    lst.erase_if([value](int x) { return x == value; });
+    lst.push_back(value);
+  }
+  stop = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  lst.synchronize();
+  ASSERT_FALSE(corrupted.load());
+  ASSERT_TRUE(lst.size() == kValues);
+}
+
+TEST(Splice, RelinksWithoutAllocation) {
+  SetupTest();
+  List<int, AllocatorWithCount<int>> first = {1, 2, 3};
+  List<int, AllocatorWithCount<int>> second = {4, 5};
+  size_t allocated = MemoryManager::allocator_allocated;
+  size_t constructed = MemoryManager::allocator_constructed;
+
+  first.splice(first.end(), first, first.begin());
+  ASSERT_TRUE(AreListsEqual(first, List<int>({2, 3, 1})));
+
+  first.splice(first.begin(), second, ++second.begin());
+  ASSERT_TRUE(AreListsEqual(first, List<int>({5, 2, 3, 1})));
+  ASSERT_TRUE(second.size() == 1);
+
+  second.splice(second.end(), first);
+  ASSERT_TRUE(first.empty());
+  ASSERT_TRUE(AreListsEqual(second, List<int>({4, 5, 2, 3, 1})));
+  ASSERT_TRUE(MemoryManager::allocator_allocated == allocated);
+  ASSERT_TRUE(MemoryManager::allocator_constructed == constructed);
+
+  first.splice(first.end(), second, second.begin(), second.end());
+  ASSERT_TRUE(second.empty());
+  ASSERT_TRUE(first.size() == 5);
+}
+
+TEST(LruCache, EvictsLeastRecentlyUsed) {
+  LruCache<int, std::string> cache(3);
+  cache.put(1, "one");
+  cache.put(2, "two");
+  cache.put(3, "three");
+  ASSERT_TRUE(*cache.get(1) == "one");
+
+  cache.put(4, "four");
+  ASSERT_TRUE(cache.get(2) == nullptr);
+  ASSERT_TRUE(cache.contains(1));
+  ASSERT_TRUE(cache.contains(3));
+  ASSERT_TRUE(cache.size() == 3);
+
+  cache.put(3, "THREE");
+  ASSERT_TRUE(*cache.get(3) == "THREE");
+  ASSERT_TRUE(cache.erase(1));
+  ASSERT_FALSE(cache.erase(1));
+
+  std::vector<std::pair<int, std::string>> evicted;
+  cache.evict(1, std::back_inserter(evicted));
+  ASSERT_TRUE(evicted.size() == 1 && evicted[0].first == 4);
+  cache.set_capacity(0);
+  ASSERT_TRUE(cache.empty());
+  ASSERT_TRUE(cache.get(3) == nullptr);
+}
+
+TEST(LruCache, SteadyStateDoesNotAllocate) {
+  SetupTest();
+  LruCache<int, int, AllocatorWithCount<std::pair<const int, int>>> cache(64);
+  for (int i = 0; i < 64; ++i) {
+    cache.put(i, i);
+  }
+  size_t allocated = MemoryManager::allocator_allocated;
+  for (int i = 0; i < 10000; ++i) {
+    if (cache.get(i % 100) == nullptr) {
+      cache.put(i % 100, i);
+    }
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated == allocated);
+  ASSERT_TRUE(cache.size() == 64);
+}
+
+// key whose copies and hashing fail on demand
+struct FragileKey {
+  static bool need_throw;
+
+  int value;
+
+  explicit FragileKey(int value) : value(value) {}
+
+  FragileKey(const FragileKey& other) : value(other.value) {
+    if (need_throw) {
+      throw std::runtime_error("key copy");
+    }
+  }
+
+  FragileKey& operator=(const FragileKey& other) {
+    if (need_throw) {
+      throw std::runtime_error("key copy");
+    }
+    value = other.value;
+    return *this;
+  }
+
+  bool operator==(const FragileKey& other) const {
+    return value == other.value;
+  }
+};
+
+bool FragileKey::need_throw = false;
+
+struct FragileKeyHash {
+  static bool need_throw;
+
+  size_t operator()(const FragileKey& key) const {
+    if (need_throw) {
+      throw std::runtime_error("key hash");
+    }
+    return std::hash<int>()(key.value);
+  }
+};
+
+bool FragileKeyHash::need_throw = false;
+
+TEST(LruCache, ThrowingKeyLeavesNoUnindexedEntries) {
+  using Cache = LruCache<FragileKey, int,
+                         std::allocator<std::pair<const FragileKey, int>>,
+                         FragileKeyHash>;
+  Cache cache(2);
+  // the first insert reaches the index only after the list holds the entry
+  FragileKeyHash::need_throw = true;
+  ASSERT_THROW(cache.put(FragileKey(1), 1), std::runtime_error);
+  FragileKeyHash::need_throw = false;
+  ASSERT_TRUE(cache.empty() && !cache.contains(FragileKey(1)));
+
+  cache.put(FragileKey(1), 1);
+  cache.put(FragileKey(2), 2);
+  // a full cache gives up the victim when the new key cannot take its node
+  FragileKey::need_throw = true;
+  ASSERT_THROW(cache.put(FragileKey(3), 3), std::runtime_error);
+  FragileKey::need_throw = false;
+  ASSERT_TRUE(cache.size() == 1);
+  ASSERT_TRUE(!cache.contains(FragileKey(1)) && cache.contains(FragileKey(2)));
+
+  // the freed capacity is usable and no key shows up twice
+  cache.put(FragileKey(3), 3);
+  cache.put(FragileKey(2), 20);
+  cache.put(FragileKey(4), 4);
+  ASSERT_TRUE(cache.size() == 2);
+  ASSERT_TRUE(*cache.get(FragileKey(2)) == 20);
+  ASSERT_TRUE(*cache.get(FragileKey(4)) == 4);
+  ASSERT_TRUE(!cache.contains(FragileKey(3)));
+  ASSERT_TRUE(cache.evict(2) == 2 && cache.empty());
+}
+
+TEST(LruCache, ThrowingOutputLeavesNoUnindexedEntries) {
+  // takes two entries, then throws
+  struct ShortSink {
+    std::vector<std::pair<int, int>>* taken;
+
+    ShortSink& operator*() { return *this; }
+    ShortSink& operator++() { return *this; }
+    ShortSink& operator=(std::pair<int, int>&& entry) {
+      if (taken->size() == 2) {
+        throw std::runtime_error("sink full");
+      }
+      taken->push_back(entry);
+      return *this;
+    }
+  };
+
+  LruCache<int, int> cache(8);
+  for (int i = 0; i < 8; ++i) {
+    cache.put(i, i);
+  }
+  std::vector<std::pair<int, int>> taken;
+  ASSERT_THROW(cache.evict(5, ShortSink{&taken}), std::runtime_error);
+  // the two written entries and the one being written are gone
+  ASSERT_TRUE((taken == std::vector<std::pair<int, int>>{{0, 0}, {1, 1}}));
+  ASSERT_TRUE(cache.size() == 5);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_TRUE(!cache.contains(i));
+  }
+  for (int i = 3; i < 8; ++i) {
+    ASSERT_TRUE(*cache.get(i) == i);
+  }
+  ASSERT_TRUE(cache.evict(8) == 5 && cache.empty());
+}
+
+TEST(LruCache, Sharded) {
+  ShardedLruCache<int, int, 4> cache(64);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t] {
+      for (int i = 0; i < 1000; ++i) {
+        cache.put(t * 1000 + i % 16, i);
+        cache.get(t * 1000 + i % 16);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_TRUE(cache.size() <= 64);
+  ASSERT_TRUE(cache.get(3015).has_value());
+}
+
+TEST(Copy, AcrossAllocatorTypes) {
+  SetupTest();
+  List<int> source;
+  for (int i = 0; i < 1000; ++i) {
+    source.push_back(i);
+  }
+  {
+    List<int, AllocatorWithCount<int>> counted(source);
+    ASSERT_TRUE(counted.size() == 1000);
+    ASSERT_TRUE(std::equal(source.cbegin(), source.cend(), counted.cbegin()));
+    ASSERT_TRUE(MemoryManager::allocator_constructed == 1000);
+
+    counted.pop_front();
+    source = counted;
+    ASSERT_TRUE(source.size() == 999 && *source.begin() == 1);
+    counted = List<int>{7, 8};
+    ASSERT_TRUE(counted.size() == 2 && *counted.begin() == 7);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(Copy, AssignmentIsAllOrNothing) {
+  ThrowingAccountant::need_throw = false;
+  List<ThrowingAccountant> source(6);
+  List<ThrowingAccountant, AllocatorWithCount<ThrowingAccountant>> target(2);
+  Accountant::reset();
+  ThrowingAccountant::need_throw = true;
+  ASSERT_THROW(target = source, std::string);
+  ThrowingAccountant::need_throw = false;
+  // the fourth copy throws; it and the three finished copies are destroyed
+  ASSERT_TRUE(Accountant::ctor_calls == 4 && Accountant::dtor_calls == 4);
+  ASSERT_TRUE(target.size() == 2);
+}
+
+// constant evaluation rejects leaks, double frees and reads of dead nodes,
+// so these double as checks of the node lifetime handling
+constexpr int ConstexprListOperations() {
+  List<int> lst = {1, 2, 3};
+  lst.push_back(4);
+  lst.insert(lst.begin(), 0);
+  lst.erase(++lst.begin());
+  List<int> copy(lst);
+  copy.pop_back();
+  copy.push_front(10);
+  int sum = 0;
+  for (int value : copy) {
+    sum += value;
+  }
+  return sum + static_cast<int>(lst.size()) * 100;
+}
+
+constexpr bool ConstexprListAssignAndReserve() {
+  List<std::pair<int, int>> lst(3, {1, 2});
+  List<std::pair<int, int>> other;
+  other.reserve(4);
+  other = lst;
+  other.emplace_back();
+  lst.clear();
+  return lst.empty() && other.size() == 4 && other.begin()->second == 2 &&
+         (--other.end())->first == 0;
+}
+
+static_assert(ConstexprListOperations() == 415);
+static_assert(ConstexprListAssignAndReserve());
+
+TEST(Constexpr, LookupTable) {
+  constexpr auto kTable = [] {
+    List<int> squares;
+    for (int i = 0; i < 8; ++i) {
+      squares.push_back(i * i);
+    }
+    std::array<int, 8> table{};
+    std::copy(squares.cbegin(), squares.cend(), table.begin());
+    return table;
+  }();
+  ASSERT_TRUE(kTable[3] == 9 && kTable[7] == 49);
+}
+
+TEST(Reserve, NoAllocationsWithinReserve) {
+  SetupTest();
+  {
+    List<int, AllocatorWithCount<int>> lst;
+    lst.reserve(100);
+    size_t calls = MemoryManager::allocator_calls;
+    for (int round = 0; round < 2; ++round) {
+      for (int i = 0; i < 100; ++i) {
+        lst.push_back(i);
+      }
+      lst.clear();
+    }
+    ASSERT_TRUE(MemoryManager::allocator_calls == calls);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(Reserve, RunAllocatorKeepsSurplus) {
+  SetupTest();
+  using RunList = List<int, SizeClassAllocatorWithCount<int>>;
+  {
+    RunList lst;
+    lst.reserve(100);
+    // one run for the nodes and one record describing it
+    ASSERT_TRUE(MemoryManager::allocator_calls == 2);
+    // the size class rounds 101 nodes up, and the surplus is usable too
+    for (int i = 0; i < 105; ++i) {
+      lst.push_back(i);
+    }
+    ASSERT_TRUE(MemoryManager::allocator_calls == 2);
+
+    RunList other;
+    std::vector<int> values(64, 7);
+    other.push_back_bulk(values);
+    ASSERT_TRUE(MemoryManager::allocator_calls == 4);
+    lst.splice(lst.begin(), other, other.begin(), other.end());
+    ASSERT_TRUE(lst.size() == 169 && other.empty());
+    ASSERT_TRUE(*lst.begin() == 7 && *--lst.end() == 104);
+    // splice relinks, so it allocates nothing
+    ASSERT_TRUE(MemoryManager::allocator_calls == 4);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+// has allocate_at_least but does not ask for runs
+template <typename T>
+struct AtLeastAllocatorWithCount : SizeClassAllocatorWithCount<T> {
+  using node_runs = std::false_type;
+
+  template <typename U>
+  struct rebind {
+    using other = AtLeastAllocatorWithCount<U>;
+  };
+
+  AtLeastAllocatorWithCount() = default;
+
+  template <typename U>
+  AtLeastAllocatorWithCount(const AtLeastAllocatorWithCount<U>& other) {
+    std::ignore = other;
+  }
+};
+
+TEST(Reserve, RunsAreOptInAndReturnWhenEmpty) {
+  SetupTest();
+  {
+    List<int, AtLeastAllocatorWithCount<int>> nodes;
+    for (int i = 0; i < 10; ++i) {
+      nodes.push_back(i);
+    }
+    // one allocation per node and the sentinel
+    ASSERT_TRUE(MemoryManager::allocator_calls == 11);
+  }
+  SetupTest();
+  List<int, SizeClassAllocatorWithCount<int>> runs;
+  for (int i = 0; i < 10000; ++i) {
+    runs.push_back(i);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_calls < 64);
+  runs.clear();
+  ASSERT_TRUE(runs.memory_usage() == 0);
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+  // a reserve keeps them
+  runs.reserve(100);
+  runs.push_back(1);
+  runs.clear();
+  ASSERT_TRUE(runs.memory_usage() > 100 * runs.node_size);
+}
+
+TEST(Reserve, SpliceBetweenRunListsRelinks) {
+  SetupTest();
+  using RunList = List<int, SizeClassAllocatorWithCount<int>>;
+  {
+    RunList lst = {1, 2, 3};
+    const int* moved = nullptr;
+    {
+      RunList other = {4, 5, 6};
+      auto iter = ++other.begin();
+      moved = &*iter;
+      lst.splice(lst.end(), other, iter);
+      ASSERT_TRUE(&*--lst.end() == moved);
+      lst.splice(lst.begin(), other, other.begin(), other.end());
+      ASSERT_TRUE(AreListsEqual(lst, RunList({4, 6, 1, 2, 3, 5})));
+      // other's run outlives other while lst holds its nodes
+    }
+    ASSERT_TRUE(&*--lst.end() == moved);
+    lst.pop_back();
+    lst.push_back(7);
+    ASSERT_TRUE(AreListsEqual(lst, RunList({4, 6, 1, 2, 3, 7})));
+    lst.clear();
+    ASSERT_TRUE(MemoryManager::allocator_allocated ==
+                MemoryManager::allocator_deallocated);
+    lst.push_back(8);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+DetachedTask ChannelProducer(Channel<int>& channel, int count) {
+  for (int i = 0; i < count; ++i) {
+    co_await channel.push(i);
+  }
+  channel.close();
+}
+
+template <class Allocator>
+DetachedTask ChannelConsumer(Channel<int, Allocator>& channel,
+                             std::vector<int>& seen) {
+  while (std::optional<int> value = co_await channel.pop()) {
+    seen.push_back(*value);
+  }
+}
+
+DetachedTask ChannelBatchConsumer(Channel<int>& channel,
+                                  std::vector<size_t>& batches) {
+  for (;;) {
+    List<int> batch = co_await channel.pop_n(8);
+    if (batch.empty()) {
+      break;
+    }
+    batches.push_back(batch.size());
+  }
+}
+
+TEST(Channel, SuspendsWithBackpressure) {
+  Channel<int> channel(4);
+  std::vector<int> seen;
+  ChannelConsumer(channel, seen);
+  ASSERT_TRUE(seen.empty());
+  ChannelProducer(channel, 100);
+  ASSERT_TRUE(seen.size() == 100);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(seen[i] == i);
+  }
+
+  // with no consumer the producer stops at capacity and waits
+  Channel<int> full(4);
+  ChannelProducer(full, 10);
+  ASSERT_TRUE(full.size() == 4 && !full.closed());
+  ASSERT_TRUE(*full.try_pop() == 0);
+  ASSERT_TRUE(full.size() == 4);
+  std::vector<size_t> batches;
+  ChannelBatchConsumer(full, batches);
+  ASSERT_TRUE(full.closed() && full.size() == 0);
+  // the first batch also collects what the resumed producer refilled
+  ASSERT_TRUE((batches == std::vector<size_t>{8, 1}));
+}
+
+TEST(Channel, RelinksWithoutCopying) {
+  SetupTest();
+  {
+    Channel<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> channel(8);
+    for (int i = 0; i < 5; ++i) {
+      ASSERT_TRUE(channel.try_push(TypeWithCounts(i)));
+    }
+    std::optional<TypeWithCounts> value = channel.try_pop();
+    ASSERT_TRUE(value.has_value());
+    ASSERT_TRUE(*value->copy_c == 0);
+    ASSERT_TRUE(channel.size() == 4);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(Channel, HandoffDoesNotChurnTheAllocator) {
+  SetupTest();
+  {
+    Channel<int, AllocatorWithCount<int>> channel(4);
+    size_t calls = MemoryManager::allocator_calls;
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(channel.try_push(i));
+      ASSERT_TRUE(*channel.try_pop() == i);
+    }
+    // a waiting consumer gets the value without a node
+    std::vector<int> seen;
+    ChannelConsumer(channel, seen);
+    for (int i = 0; i < 100; ++i) {
+      ASSERT_TRUE(channel.try_push(i));
+    }
+    ASSERT_TRUE(seen.size() == 100);
+    ASSERT_TRUE(MemoryManager::allocator_calls == calls);
+    channel.close();
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(Channel, AcrossThreads) {
+  Channel<int> channel(16);
+  std::vector<int> seen;
+  ChannelConsumer(channel, seen);
+  std::thread producer([&] {
+    for (int i = 0; i < 10000; ++i) {
+      while (!channel.try_push(i)) {
+        std::this_thread::yield();
+      }
+    }
+    channel.close();
+  });
+  producer.join();
+  while (std::optional<int> value = channel.try_pop()) {
+    seen.push_back(*value);
+  }
+  ASSERT_TRUE(seen.size() == 10000);
+  ASSERT_TRUE(std::is_sorted(seen.begin(), seen.end()));
+}
+
+TEST(SlotMap, HandlesAndOrder) {
+  SlotMap<int> map;
+  std::vector<SlotMapHandle> handles;
+  for (int i = 0; i < 100; ++i) {
+    handles.push_back(map.push_back(i));
+  }
+  // growth moved the values but not the handles
+  ASSERT_TRUE(map.capacity() >= 100);
+  ASSERT_TRUE(*map.get(handles[42]) == 42);
+
+  for (int i = 0; i < 100; i += 2) {
+    ASSERT_TRUE(map.erase(handles[i]));
+  }
+  ASSERT_FALSE(map.erase(handles[0]));
+  ASSERT_TRUE(map.size() == 50);
+
+  // reuses the freed slot, yet the old handle stays stale
+  SlotMapHandle reused = map.push_front(-1);
+  ASSERT_TRUE(reused.index == handles[98].index);
+  ASSERT_TRUE(map.get(handles[98]) == nullptr);
+  ASSERT_TRUE(*map.get(reused) == -1);
+
+  std::vector<int> order(map.cbegin(), map.cend());
+  ASSERT_TRUE(order.size() == 51 && order[0] == -1 && order[1] == 1 &&
+              order.back() == 99);
+  ASSERT_TRUE(*--map.end() == 99 && *map.rbegin() == 99);
+
+  auto iter = map.find(handles[51]);
+  ASSERT_TRUE(*iter == 51);
+  map.insert(iter, 50);
+  ASSERT_TRUE(*--iter == 50);
+  ASSERT_TRUE(map.handle_of(map.begin()) == reused);
+
+  // the argument lives in the array that the push reallocates
+  SlotMap<std::string> strings;
+  while (strings.size() < strings.capacity() || strings.empty()) {
+    strings.push_back(std::string(32, 'a'));
+  }
+  strings.push_back(*strings.begin());
+  ASSERT_TRUE(*--strings.end() == std::string(32, 'a'));
+}
+
+TEST(SlotMap, AllocatorAndCopies) {
+  SetupTest();
+  {
+    SlotMap<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> map;
+    for (int i = 0; i < 20; ++i) {
+      map.emplace_back(i);
+    }
+    map.erase(map.begin());
+    auto copy = map;
+    ASSERT_TRUE(AreListsEqual(map, copy));
+    SlotMapHandle last = map.handle_of(--map.end());
+    ASSERT_TRUE(copy.get(last)->value == 19);
+
+    map.clear();
+    map = copy;
+    ASSERT_TRUE(map.size() == 19);
+    auto moved = std::move(copy);
+    ASSERT_TRUE(copy.empty() && moved.size() == 19);
+  }
+  ASSERT_TRUE(MemoryManager::allocator_constructed ==
+              MemoryManager::allocator_destroyed);
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+// counting allocator that moves along with its container
+template <typename T>
+struct MovingAllocatorWithCount : AllocatorWithCount<T> {
+  using propagate_on_container_move_assignment = std::true_type;
+
+  template <typename U>
+  struct rebind {
+    using other = MovingAllocatorWithCount<U>;
+  };
+
+  MovingAllocatorWithCount() = default;
+
+  template <typename U>
+  MovingAllocatorWithCount(const MovingAllocatorWithCount<U>& other) {
+    std::ignore = other;
+  }
+};
+
+TEST(SlotMap, MoveAssignment) {
+  SetupTest();
+  {
+    // a propagating allocator: the slots change hands without allocating
+    SlotMap<TypeWithCounts, MovingAllocatorWithCount<TypeWithCounts>> map;
+    SlotMap<TypeWithCounts, MovingAllocatorWithCount<TypeWithCounts>> target;
+    std::vector<SlotMapHandle> handles;
+    for (int i = 0; i < 20; ++i) {
+      handles.push_back(map.emplace_back(i));
+    }
+    target.emplace_back(100);
+    const TypeWithCounts* first = &*map.begin();
+    size_t allocated = MemoryManager::allocator_allocated;
+    target = std::move(map);
+    ASSERT_TRUE(MemoryManager::allocator_allocated == allocated);
+    ASSERT_TRUE(map.empty() && target.size() == 20);
+    ASSERT_TRUE(&*target.begin() == first);
+    ASSERT_TRUE(target.get(handles[7])->value == 7);
+
+    // unequal allocators that stay: the values move slot for slot
+    SlotMap<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> source;
+    SlotMap<TypeWithCounts, AllocatorWithCount<TypeWithCounts>> other;
+    for (int i = 0; i < 5; ++i) {
+      handles[i] = source.emplace_back(i);
+    }
+    source.erase(source.begin());
+    std::vector<size_t> copies;
+    for (const TypeWithCounts& value : source) {
+      copies.push_back(*value.copy_c);
+    }
+    other = std::move(source);
+    ASSERT_TRUE(source.empty() && other.size() == 4);
+    ASSERT_TRUE(!other.contains(handles[0]) &&
+                other.get(handles[4])->value == 4);
+    size_t i = 0;
+    for (const TypeWithCounts& value : other) {
+      ASSERT_TRUE(*value.copy_c == copies[i++]);
+    }
+  }
+  ASSERT_TRUE(MemoryManager::allocator_constructed ==
+              MemoryManager::allocator_destroyed);
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+}
+
+TEST(Budget, ChargesAndRollsBack) {
+  using BudgetList = List<int, BudgetAllocator<int>>;
+  constexpr size_t kNode = BudgetList::node_size;
+  MemoryBudget budget(10 * kNode);
+  {
+    BudgetList lst{BudgetAllocator<int>(budget)};
+    for (int i = 0; i < 9; ++i) {
+      lst.push_back(i);
+    }
+    ASSERT_TRUE(lst.memory_usage() == 10 * kNode);
+    ASSERT_TRUE(budget.used() == lst.memory_usage());
+    try {
+      lst.push_back(9);
+      FAIL();
+    } catch (const MemoryBudgetExceeded& error) {
+      ASSERT_TRUE(error.requested() == kNode && error.limit() == 10 * kNode);
+    }
+    ASSERT_TRUE(lst.size() == 9 && budget.used() == 10 * kNode);
+    // a failed reserve gives back what it got before running out
+    lst.pop_back();
+    ASSERT_THROW(lst.reserve(20), MemoryBudgetExceeded);
+    ASSERT_TRUE(lst.memory_usage() == 9 * kNode);
+    ASSERT_TRUE(budget.used() == lst.memory_usage());
+  }
+  ASSERT_TRUE(budget.used() == 0);
+
+  // constructors roll back whole, the sentinel included
+  ASSERT_THROW(BudgetList(11, 1, BudgetAllocator<int>(budget)),
+               MemoryBudgetExceeded);
+  ASSERT_TRUE(budget.used() == 0);
+  budget.set_limit(kNode);
+  ASSERT_THROW(BudgetList(1, 1, BudgetAllocator<int>(budget)), std::bad_alloc);
+  ASSERT_TRUE(budget.used() == 0);
+  budget.set_limit(15 * kNode);
+  BudgetList source(8, 1, BudgetAllocator<int>(budget));
+  ASSERT_THROW(BudgetList copy(source), MemoryBudgetExceeded);
+  ASSERT_TRUE(budget.used() == source.memory_usage());
+}
+
+TEST(Budget, SharedAcrossListsAndRuns) {
+  SetupTest();
+  using RunAllocator = BudgetAllocator<int, SizeClassAllocatorWithCount<int>>;
+  MemoryBudget budget(1 << 20);
+  {
+    List<int, RunAllocator> runs{RunAllocator(budget)};
+    List<int, BudgetAllocator<int>> nodes{BudgetAllocator<int>(budget)};
+    runs.reserve(100);
+    nodes.reserve(100);
+    for (int i = 0; i < 100; ++i) {
+      runs.push_back(i);
+      nodes.push_back(i);
+    }
+    // the run is charged in full, surplus nodes included
+    ASSERT_TRUE(runs.memory_usage() > 101 * runs.node_size);
+    ASSERT_TRUE(budget.used() ==
+                runs.memory_usage() + nodes.memory_usage());
+    ASSERT_TRUE(MemoryManager::allocator_allocated == runs.memory_usage());
+  }
+  ASSERT_TRUE(budget.used() == 0);
+}
+
+static_assert(std::bidirectional_iterator<List<int>::iterator>);
+static_assert(std::bidirectional_iterator<List<int>::const_iterator>);
+static_assert(std::ranges::bidirectional_range<const List<int>>);
+static_assert(std::ranges::sized_range<List<int>>);
+static_assert(std::ranges::common_range<List<int>>);
+static_assert(std::is_same_v<std::ranges::range_reference_t<const List<int>>,
+                             const int&>);
+static_assert(std::is_convertible_v<List<int>::iterator,
+                                    List<int>::const_iterator>);
+static_assert(!std::is_convertible_v<List<int>::const_iterator,
+                                     List<int>::iterator>);
+
+constexpr bool ConstexprPipeline() {
+  List<int> lst = {1, 2, 3, 4, 5, 6};
+  auto squares = lst | std::views::filter([](int v) { return v % 2 == 0; }) |
+                 std::views::transform([](int v) { return v * v; }) |
+                 to_list();
+  return squares.size() == 3 && *squares.begin() == 4 &&
+         *squares.rbegin() == 36;
+}
+static_assert(ConstexprPipeline());
+
+TEST(Ranges, PipelinesIntoList) {
+  SetupTest();
+  using CountedList = List<long, AllocatorWithCount<long>>;
+  const List<int> source = {5, 1, 4, 2, 3};
+  {
+    // filter is not sized: the chain grows node by node, then links once
+    auto odd = source | std::views::filter([](int v) { return v % 2 != 0; }) |
+               std::views::transform([](int v) { return long{v} * 10; }) |
+               to_list<CountedList>();
+    ASSERT_TRUE(AreListsEqual(odd, std::vector<long>{50, 10, 30}));
+    ASSERT_TRUE(MemoryManager::allocator_calls == 4);
+
+    auto reversed = source | std::views::reverse | to_list();
+    ASSERT_TRUE(AreListsEqual(reversed, std::vector<int>{3, 2, 4, 1, 5}));
+
+    // a sized pipeline over a run allocator gets one run for all nodes
+    MemoryManager::allocator_calls = 0;
+    auto runs = source | std::views::transform([](int v) { return v + 1; }) |
+                to_list<List<int, SizeClassAllocatorWithCount<int>>>();
+    ASSERT_TRUE(MemoryManager::allocator_calls == 2);
+    ASSERT_TRUE(std::ranges::equal(runs, std::vector<int>{6, 2, 5, 3, 4}));
+  }
+  ASSERT_TRUE(MemoryManager::allocator_allocated ==
+              MemoryManager::allocator_deallocated);
+
+  ThrowingAccountant::need_throw = false;
+  List<ThrowingAccountant> target(2);
+  Accountant::reset();
+  ThrowingAccountant::need_throw = true;
+  ASSERT_THROW(target.append_range(std::views::iota(0, 10) |
+                                   std::views::transform([](int v) {
+                                     return ThrowingAccountant(v);
+                                   })),
+               std::string);
+  ThrowingAccountant::need_throw = false;
+  ASSERT_TRUE(target.size() == 2);
+  ASSERT_TRUE(Accountant::ctor_calls == Accountant::dtor_calls);
+}
+
+// runs on single-node machines too, where placement is left to the kernel
+TEST(Numa, AllocatorAndMigration) {
+  int last = Numa::node_count() - 1;
+  List<int, NumaAllocator<int>> lst{NumaAllocator<int>(0)};
+  std::vector<int> expected;
+  for (int i = 0; i < 10000; ++i) {
+    lst.push_back(i);
+    expected.push_back(i);
+  }
+  lst.erase(lst.begin());
+  expected.erase(expected.begin());
+  auto iter = lst.begin();
+  int* value = &*iter;
+  ASSERT_TRUE(Numa::node_of(value) == 0 || Numa::node_of(value) == -1);
+
+  size_t moved = lst.migrate_to_node(last);
+  // 9999 nodes in 32-byte blocks span about 80 pages
+  ASSERT_TRUE(moved <= 100);
+  ASSERT_TRUE(moved > 0 || Numa::node_of(value) == -1);
+  ASSERT_TRUE(lst.get_allocator().node() == last);
+  ASSERT_TRUE(&*iter == value);
+  ASSERT_TRUE(Numa::node_of(value) == last || Numa::node_of(value) == -1);
+  ASSERT_TRUE(std::equal(lst.begin(), lst.end(), expected.begin(),
+                         expected.end()));
+
+  // freed blocks are reused first, so their pages move with the list
+  size_t pages = lst.migrate_to_node(last);
+  for (int i = 0; i < 5000; ++i) {
+    lst.pop_front();
+  }
+  ASSERT_TRUE(lst.migrate_to_node(last) == pages);
+
+  // values kept out of line move along with their nodes
+  List<Huge, NumaAllocator<Huge>> big = {1, 2, 3};
+  // one or two slab pages of nodes and a page per value
+  ASSERT_TRUE(big.migrate_to_node(last) <= 5);
+  ASSERT_TRUE(big.size() == 3);
+}
+
+// the slabs fall back to regular pages where huge pages are unavailable
+TEST(HugePages, SlabsAndReuse) {
+  HugePageArena arena(false);
+  void* block = arena.allocate(24, 8);
+  ASSERT_TRUE(reinterpret_cast<uintptr_t>(block) %
+                  HugePageArena::kHugePageSize ==
+              0);
+  ASSERT_TRUE(arena.backing() != HugePageBacking::kHugeTlb);
+  arena.deallocate(block, 24, 8);
+  ASSERT_TRUE(arena.allocate(24, 8) == block);
+  // a zero-byte block takes the smallest class
+  void* empty = arena.allocate(0, 1);
+  ASSERT_TRUE(empty != nullptr && empty != block);
+  arena.deallocate(empty, 0, 1);
+  ASSERT_TRUE(arena.allocate(16, 8) == empty);
+  HugePageAllocator<int> zero;
+  zero.deallocate(zero.allocate(0), 0);
+
+  HugePageAllocator<int> alloc;
+  List<int, HugePageAllocator<int>> lst(alloc);
+  std::list<int> expected;
+  // 32-byte blocks, 65536 to a slab
+  for (int i = 0; i < 100000; ++i) {
+    lst.push_back(i);
+    expected.push_back(i);
+  }
+  ASSERT_TRUE(alloc.arena()->slab_count() == 2);
+  for (int i = 0; i < 50000; ++i) {
+    lst.pop_front();
+    lst.push_back(i);
+    expected.pop_front();
+    expected.push_back(i);
+  }
+  ASSERT_TRUE(alloc.arena()->slab_count() == 2);
+  ASSERT_TRUE(std::ranges::equal(lst, expected));
+
+  List<Huge, HugePageAllocator<Huge>> big = {1, 2, 3};
+  big.pop_front();
+  ASSERT_TRUE(big.size() == 2 && big.begin()->value == 2);
+}
+
+#ifndef LIST_CHECKED_ITERATORS
+// unchecked iterators stay a bare node pointer
+static_assert(sizeof(List<int>::iterator) == sizeof(void*));
+static_assert(std::is_trivially_copyable_v<List<int>::iterator>);
+#endif
+
+TEST(Tracing, RecordsListEvents) {
+  using TracedList = List<int, std::allocator<int>, RingBufferListTracer>;
+  RingBufferListTracer::reset();
+  {
+    TracedList lst = {1, 2, 3};
+    TracedList other;
+    other = lst;
+    lst.erase(lst.begin());
+  }
+
+  size_t counts[5] = {};
+  for (const ListTraceRecord& record : RingBufferListTracer::snapshot()) {
+    counts[static_cast<size_t>(record.event)] += 1;
+  }
+  ASSERT_TRUE(counts[static_cast<size_t>(ListEvent::kConstructNode)] == 6);
+  ASSERT_TRUE(counts[static_cast<size_t>(ListEvent::kAllocateBaseNode)] == 2);
+  ASSERT_TRUE(counts[static_cast<size_t>(ListEvent::kCopyAssign)] == 1);
+  // the explicit erase plus the five pops done by the destructors
+  ASSERT_TRUE(counts[static_cast<size_t>(ListEvent::kErase)] == 6);
+
+  std::stringstream json;
+  RingBufferListTracer::dump_chrome_trace(json);
+  ASSERT_TRUE(json.str().find("\"traceEvents\"") != std::string::npos);
+  ASSERT_TRUE(json.str().find("\"name\":\"copy_assign\"") !=
+              std::string::npos);
+}
+
+// the default hook is an empty constant expression that cannot throw, so
+// there is nothing left of it to call once inlined
+static_assert((NullListTracer::record(ListEvent::kErase, nullptr, 1), true));
+static_assert(noexcept(NullListTracer::record(ListEvent::kErase, nullptr, 1)));
+static_assert(std::is_empty_v<NullListTracer>);
+
+TEST(Tracing, RingIsCreatedOnRegistration) {
+  RingBufferListTracer::reset();
+  std::thread([] {
+    RingBufferListTracer::register_thread();
+    List<int, std::allocator<int>, RingBufferListTracer> lst;
+    lst.push_back(1);
+  }).join();
+  // sentinel, element and the destructor's erase
+  ASSERT_TRUE(RingBufferListTracer::snapshot().size() == 3);
+}
+
 int main(int argc, char** argv) {
   testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();